@@ -0,0 +1,62 @@
+#ifndef BENCH_SAMPLES_H
+#define BENCH_SAMPLES_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "headers/CsvLoader.h"
+#include "headers/Matrix.h"
+
+using namespace std;
+
+// Sample sets shared by the benchmark and check programs: one column matrix
+// per sample, as trainWithValidation and computeMetrics take them.
+template<typename T>
+struct Samples {
+    vector<Matrix<T>> inputs;
+    vector<Matrix<T>> targets;
+};
+
+template<typename T>
+Samples<T> loadSamples(const string& path, const CsvColumns& columns) {
+    CsvTable<T> table = loadCsv<T>(path, columns);
+    Samples<T> samples;
+    for (size_t r = 0; r < table.rows; ++r) {
+        samples.inputs.push_back(Matrix<T>(vector<T>(table.features.begin() + long(r * table.inputDim), table.features.begin() + long((r + 1) * table.inputDim))));
+        samples.targets.push_back(Matrix<T>(vector<T>(table.labels.begin() + long(r * table.outputDim), table.labels.begin() + long((r + 1) * table.outputDim))));
+    }
+    return samples;
+}
+
+inline Samples<double> loadAdderSamples() {
+    return loadSamples<double>("datasets/binary_adder_dataset.csv", {{"a0", "b0", "c0", "a1", "b1"}, {"s0", "s1", "c2"}});
+}
+
+// count samples of random 0/1 inputs and targets, drawn from mt19937(seed)
+// one sample at a time, so a seed always gives the same set.
+template<typename T>
+Samples<T> randomSamples(size_t count, size_t in, size_t out, uint32_t seed) {
+    Samples<T> samples;
+    mt19937 rng(seed);
+    for (size_t s = 0; s < count; ++s) {
+        Matrix<T> x(in, 1), y(out, 1);
+        for (size_t i = 0; i < in; ++i) x(i, 0) = T(rng() % 2);
+        for (size_t i = 0; i < out; ++i) y(i, 0) = T(rng() % 2);
+        samples.inputs.push_back(x);
+        samples.targets.push_back(y);
+    }
+    return samples;
+}
+
+// The samples one per row, for predictBatch and the MatrixView overloads.
+template<typename T>
+vector<T> rowMajor(const vector<Matrix<T>>& samples) {
+    vector<T> rows;
+    for (const Matrix<T>& sample : samples) {
+        rows.insert(rows.end(), sample.getData(), sample.getData() + sample.size());
+    }
+    return rows;
+}
+
+#endif // BENCH_SAMPLES_H
@@ -0,0 +1,125 @@
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "headers/MLP.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+
+// Checks that steady-state training makes no heap allocations. Every
+// allocation in the process goes through the operator new below. Each
+// trainWithValidation call has a fixed setup cost (its thread pool and
+// shuffle order), so a case trains a 1-epoch call and a (1 + N)-epoch call
+// after warming up, and the two counts must be equal: the N extra epochs
+// allocated nothing. Exits nonzero if any case allocates.
+
+atomic<size_t> allocationCount{0};
+
+// Out of line so GCC never pairs an inlined malloc() or free() with the
+// other side of a new-expression and warns about a mismatch.
+__attribute__((noinline)) void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(size_t size, align_val_t alignment) {
+    ++allocationCount;
+    const size_t align = size_t(alignment);
+    if (void* p = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, align_val_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+const int warmupEpochs = 5;
+const int steadyEpochs = 200;
+
+// Allocations made by one call of train(epochs).
+template<typename Train>
+size_t allocationsFor(Train train, int epochs) {
+    const size_t before = allocationCount;
+    train(epochs);
+    return allocationCount - before;
+}
+
+// Prints the case and returns true when the extra epochs allocated nothing.
+template<typename Train>
+bool check(const string& name, Train train) {
+    train(warmupEpochs);
+    const size_t setup = allocationsFor(train, 1);
+    const size_t total = allocationsFor(train, 1 + steadyEpochs);
+    const size_t steady = total > setup ? total - setup : 0;
+    cout << left << setw(40) << name << right << setw(10) << setup << setw(12) << steady << setw(8) << (steady == 0 ? "ok" : "FAIL") << endl;
+    return steady == 0 && total >= setup;
+}
+
+template<typename T>
+bool checkModel(const string& name, MLP<T>& model, const Samples<T>& samples, bool views) {
+    if (!views) {
+        return check(name, [&](int epochs) {
+            model.trainWithValidation(samples.inputs, samples.targets, samples.inputs, samples.targets, epochs, false);
+        });
+    }
+    const size_t rows = samples.inputs.size();
+    const vector<T> features = rowMajor(samples.inputs);
+    const vector<T> labels = rowMajor(samples.targets);
+    const MatrixView<const T> x(features.data(), rows, model.inputSize(), model.inputSize());
+    const MatrixView<const T> y(labels.data(), rows, model.outputSize(), model.outputSize());
+    return check(name, [&](int epochs) {
+        model.trainWithValidation(x, y, x, y, epochs, false);
+    });
+}
+
+int main() {
+    cout << "Heap allocations in steady-state training (" << steadyEpochs << " epochs after " << warmupEpochs << " warm-up)" << endl;
+    cout << left << setw(40) << "Case" << right << setw(10) << "per call" << setw(12) << "per epochs" << setw(8) << "result" << endl;
+
+    const Samples<double> adder = randomSamples<double>(256, 5, 3, 5);
+    const Samples<float> wide = randomSamples<float>(512, 17, 9, 5);
+    bool ok = true;
+
+    {
+        MLP<double> model({5, 16, 8, 3}, 0.3, 32, InitConfig{InitScheme::Uniform, 1});
+        ok = checkModel("double full-batch, 1 thread", model, adder, false) && ok;
+    }
+    {
+        MLP<double> model({5, 16, 8, 3}, 0.3, 32, InitConfig{InitScheme::Uniform, 1});
+        model.setThreadCount(4);
+        ok = checkModel("double full-batch, 4 threads", model, adder, false) && ok;
+    }
+    {
+        MLP<double> model({5, 16, 8, 3}, 0.05, 16, InitConfig{InitScheme::XavierUniform, 2});
+        OptimizerConfig adam;
+        adam.kind = OptimizerKind::Adam;
+        model.setOptimizer(adam);
+        model.setMiniBatches(true, 3);
+        model.setThreadCount(2);
+        ok = checkModel("double Adam mini-batch, 2 threads", model, adder, false) && ok;
+    }
+    {
+        MLP<double> model({5, 16, 3}, 0.3, 32, InitConfig{InitScheme::Uniform, 4});
+        model.setEarlyStopping({1000000, 0.0, 10, true});
+        ok = checkModel("double early stopping, restore best", model, adder, false) && ok;
+    }
+    {
+        MLP<float> model({17, 64, 9}, 0.5f, 32, InitConfig{InitScheme::XavierUniform, 5});
+        model.setMiniBatches(true, 6);
+        ok = checkModel("float mini-batch, row views", model, wide, true) && ok;
+    }
+
+    cout << (ok ? "Steady-state training makes no heap allocations." : "Steady-state training ALLOCATES!") << endl;
+    return ok ? 0 : 1;
+}
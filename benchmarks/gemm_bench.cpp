@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "headers/Matrix.h"
+
+using namespace std;
+
+// Textbook i-j-k product the blocked kernels are measured against.
+template<typename T>
+void naiveMultiply(const Matrix<T>& a, const Matrix<T>& b, Matrix<T>& c) {
+    for (size_t i = 0; i < a.getRows(); ++i) {
+        for (size_t j = 0; j < b.getCols(); ++j) {
+            T sum = T{};
+            for (size_t k = 0; k < a.getCols(); ++k) {
+                sum += a(i, k) * b(k, j);
+            }
+            c(i, j) = sum;
+        }
+    }
+}
+
+template<typename Fn>
+double secondsPerCall(Fn fn) {
+    using Clock = chrono::steady_clock;
+    fn();
+    size_t calls = 0;
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++calls;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return elapsed / double(calls);
+}
+
+template<typename T>
+T maxAbsDifference(const Matrix<T>& a, const Matrix<T>& b) {
+    T worst = T{};
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = max(worst, T(fabs(a.getData()[i] - b.getData()[i])));
+    }
+    return worst;
+}
+
+template<typename T>
+bool benchShape(const string& typeName, size_t M, size_t N, size_t K) {
+    Matrix<T> a(M, K), b(K, N), expected(M, N), actual(M, N);
+    a.randomize();
+    b.randomize();
+
+    const double flops = 2.0 * double(M) * double(N) * double(K);
+    double naiveSeconds = secondsPerCall([&] { naiveMultiply(a, b, expected); });
+
+    cout << left << setw(8) << typeName << setw(18) << (to_string(M) + "x" + to_string(K) + "x" + to_string(N)) << setw(10) << "naive" << right << setw(10) << fixed << setprecision(2) << flops / naiveSeconds * 1e-9 << " GFLOP/s" << endl;
+
+    bool ok = true;
+    const T tolerance = T(1e-4) * T(K);
+    for (blas::SimdLevel level : {blas::SimdLevel::Scalar, blas::SimdLevel::AVX2, blas::SimdLevel::AVX512}) {
+        if (blas::setSimdLevel(level) != level) continue;
+
+        double seconds = secondsPerCall([&] {
+            if (N == 1) {
+                blas::gemv(M, K, a.getData(), K, b.getData(), actual.getData());
+            } else {
+                blas::gemm(M, N, K, a.getData(), K, b.getData(), N, actual.getData(), N);
+            }
+        });
+        T error = maxAbsDifference(expected, actual);
+        bool match = error <= tolerance;
+        ok = ok && match;
+
+        cout << left << setw(8) << "" << setw(18) << (N == 1 ? "gemv" : "gemm") << setw(10) << blas::simdLevelName(level) << right << setw(10) << fixed << setprecision(2) << flops / seconds * 1e-9 << " GFLOP/s" << setw(8) << setprecision(1) << naiveSeconds / seconds << "x  max err " << scientific << setprecision(1) << double(error) << (match ? "" : "  MISMATCH") << endl;
+    }
+    blas::setSimdLevel(blas::detectSimdLevel());
+
+    if (maxAbsDifference(expected, a * b) > tolerance) {
+        cout << "Matrix::operator* disagrees with the naive product!" << endl;
+        ok = false;
+    }
+    return ok;
+}
+
+template<typename T>
+bool benchType(const string& typeName) {
+    bool ok = true;
+    ok = benchShape<T>(typeName, 16, 1, 5) && ok;
+    ok = benchShape<T>(typeName, 256, 1, 256) && ok;
+    ok = benchShape<T>(typeName, 1024, 1, 1024) && ok;
+    ok = benchShape<T>(typeName, 16, 64, 5) && ok;
+    ok = benchShape<T>(typeName, 64, 64, 64) && ok;
+    ok = benchShape<T>(typeName, 127, 131, 129) && ok;
+    ok = benchShape<T>(typeName, 256, 256, 256) && ok;
+    ok = benchShape<T>(typeName, 512, 512, 512) && ok;
+    return ok;
+}
+
+int main() {
+    cout << "Detected SIMD level: " << blas::simdLevelName(blas::detectSimdLevel()) << endl;
+    bool ok = benchType<double>("double");
+    ok = benchType<float>("float") && ok;
+    cout << (ok ? "All kernels match the naive product." : "Kernel mismatch against the naive product!") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "headers/StaticMLP.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Times every call on its own so the tail of the distribution is visible.
+template<typename Fn>
+vector<double> perCallNanoseconds(size_t calls, Fn fn) {
+    vector<double> samples(calls);
+    for (size_t i = 0; i < calls / 10; ++i) {
+        fn(i);
+    }
+    for (size_t i = 0; i < calls; ++i) {
+        auto start = Clock::now();
+        fn(i);
+        samples[i] = chrono::duration<double, nano>(Clock::now() - start).count();
+    }
+    sort(samples.begin(), samples.end());
+    return samples;
+}
+
+double percentile(const vector<double>& sorted, double p) {
+    return sorted[min(sorted.size() - 1, size_t(p * double(sorted.size())))];
+}
+
+// Net is the StaticMLP for the architecture; it is built from the runtime
+// MLP so both score with the same parameters.
+template<typename Net>
+bool benchNetwork() {
+    const vector<int> architecture(Net::layerSizes.begin(), Net::layerSizes.end());
+    MLP<double> mlp(architecture);
+    const Net staticNet(mlp);
+    const size_t in = mlp.inputSize();
+    const size_t out = mlp.outputSize();
+    const size_t rows = 4096;
+
+    vector<double> inputs(rows * in), outputs(rows * out), batchOutputs(rows * out);
+    mt19937 rng(7);
+    for (double& x : inputs) {
+        x = double(rng() % 2);
+    }
+
+    vector<double> forwardTimes = perCallNanoseconds(20000, [&](size_t i) {
+        const size_t row = i % rows;
+        Matrix<double> input(vector<double>(inputs.begin() + row * in, inputs.begin() + (row + 1) * in));
+        Matrix<double> output = mlp.forward(input);
+        outputs[row * out] = output(0, 0);
+    });
+
+    vector<double> predictTimes = perCallNanoseconds(200000, [&](size_t i) {
+        const size_t row = i % rows;
+        mlp.predict(inputs.data() + row * in, outputs.data() + row * out);
+    });
+
+    vector<double> staticOutputs(rows * out);
+    vector<double> staticTimes = perCallNanoseconds(200000, [&](size_t i) {
+        const size_t row = i % rows;
+        staticNet.predict(inputs.data() + row * in, staticOutputs.data() + row * out);
+    });
+
+    auto start = Clock::now();
+    size_t batches = 0;
+    do {
+        mlp.predictBatch(inputs.data(), rows, batchOutputs.data());
+        ++batches;
+    } while (Clock::now() - start < chrono::milliseconds(200));
+    double batchNsPerRow = chrono::duration<double, nano>(Clock::now() - start).count() / double(batches * rows);
+
+    for (size_t row = 0; row < rows; ++row) {
+        mlp.predict(inputs.data() + row * in, outputs.data() + row * out);
+    }
+    double worst = 0.0;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        worst = max(worst, fabs(outputs[i] - batchOutputs[i]));
+        worst = max(worst, fabs(outputs[i] - staticOutputs[i]));
+    }
+
+    string arch;
+    for (size_t i = 0; i < architecture.size(); ++i) {
+        arch += to_string(architecture[i]) + (i + 1 < architecture.size() ? "-" : "");
+    }
+    cout << left << setw(12) << arch << right << fixed << setprecision(0)
+         << setw(10) << percentile(forwardTimes, 0.5) << setw(10) << percentile(forwardTimes, 0.99)
+         << setw(10) << percentile(predictTimes, 0.5) << setw(10) << percentile(predictTimes, 0.99)
+         << setw(12) << percentile(staticTimes, 0.5)
+         << setw(14) << setprecision(1) << batchNsPerRow
+         << setw(12) << scientific << setprecision(1) << worst << endl;
+    return worst < 1e-12;
+}
+
+// Trains a StaticMLP and the MLP it was built from side by side, with every
+// other first-layer weight pruned, and compares their parameters. The two
+// sum in different orders, so they agree to tolerance rather than bit for
+// bit. Also fails if the epoch counts differ, a pruned weight regrows, or
+// toMLP() does not round-trip the parameters and masks exactly.
+template<typename T, int... Layers>
+bool checkTraining(const char* dtype, double tolerance) {
+    const vector<int> architecture{Layers...};
+    MLP<T> mlp(architecture, T(0.5), 32, InitConfig{InitScheme::Uniform, 3});
+    vector<Matrix<T>> masks;
+    for (size_t i = 0; i + 1 < architecture.size(); ++i) {
+        Matrix<T> mask(architecture[i + 1], architecture[i]);
+        for (size_t k = 0; k < mask.size(); ++k) {
+            mask.getData()[k] = i > 0 || k % 2 == 0 ? T(1.0) : T(0.0);
+        }
+        masks.push_back(mask);
+    }
+    mlp.setWeightMasks(masks);
+    StaticMLP<T, Layers...> staticNet(mlp);
+
+    const Samples<T> samples = randomSamples<T>(256, size_t(architecture.front()), size_t(architecture.back()), 11);
+    const vector<Matrix<T>>& inputs = samples.inputs;
+    const vector<Matrix<T>>& targets = samples.targets;
+    const vector<Matrix<T>> none;
+    const int epochs = 300;
+    bool ok = mlp.trainWithValidation(inputs, targets, none, none, epochs, false) == staticNet.trainWithValidation(inputs, targets, none, none, epochs, false);
+
+    const MLP<T> trained = staticNet.toMLP();
+    const MLP<T> roundTrip = StaticMLP<T, Layers...>(trained).toMLP();
+    ok = ok && trained.hasWeightMasks() && roundTrip.hasWeightMasks();
+    double worst = 0.0;
+    for (size_t i = 0; i + 1 < architecture.size(); ++i) {
+        for (const auto& pair : {make_pair(&mlp.getWeights(i), &trained.getWeights(i)), make_pair(&mlp.getBiases(i), &trained.getBiases(i))}) {
+            for (size_t k = 0; k < pair.first->size(); ++k) {
+                worst = max(worst, fabs(double(pair.first->getData()[k]) - double(pair.second->getData()[k])));
+            }
+        }
+        const Matrix<T>& w = trained.getWeights(i);
+        for (size_t k = 0; k < w.size(); ++k) {
+            ok = ok && (masks[i].getData()[k] != T{} || w.getData()[k] == T{});
+            ok = ok && w.getData()[k] == roundTrip.getWeights(i).getData()[k] && masks[i].getData()[k] == roundTrip.getWeightMask(i).getData()[k];
+        }
+        ok = ok && equal(trained.getBiases(i).getData(), trained.getBiases(i).getData() + trained.getBiases(i).size(), roundTrip.getBiases(i).getData());
+    }
+    ok = ok && worst < tolerance;
+
+    string arch;
+    for (size_t i = 0; i < architecture.size(); ++i) {
+        arch += to_string(architecture[i]) + (i + 1 < architecture.size() ? "-" : "");
+    }
+    cout << left << setw(12) << arch << setw(8) << dtype << right << setw(12) << scientific << setprecision(1) << worst
+         << setw(12) << fixed << setprecision(6) << double(mlp.evaluate(inputs, targets)) << setw(12) << double(staticNet.evaluate(inputs, targets))
+         << setw(8) << (ok ? "ok" : "FAIL") << endl;
+    return ok;
+}
+
+int main() {
+    cout << "Per-call latency in ns (" << blas::simdLevelName(blas::simdLevel()) << " kernels)" << endl;
+    cout << left << setw(12) << "Network" << right << setw(10) << "fwd p50" << setw(10) << "fwd p99" << setw(10) << "pred p50" << setw(10) << "pred p99" << setw(12) << "static p50" << setw(14) << "batch ns/row" << setw(12) << "max diff" << endl;
+
+    bool ok = benchNetwork<StaticMLP<double, 2, 8, 1>>();
+    ok = benchNetwork<StaticMLP<double, 5, 8, 3>>() && ok;
+    ok = benchNetwork<StaticMLP<double, 5, 16, 3>>() && ok;
+    ok = benchNetwork<StaticMLP<double, 5, 32, 3>>() && ok;
+    ok = benchNetwork<StaticMLP<double, 5, 20, 10, 3>>() && ok;
+    cout << (ok ? "predictBatch and StaticMLP match predict." : "predictBatch or StaticMLP disagrees with predict!") << endl;
+
+    cout << endl << "StaticMLP training against MLP (300 full-batch epochs, half of layer 1 pruned)" << endl;
+    cout << left << setw(12) << "Network" << setw(8) << "dtype" << right << setw(12) << "max diff" << setw(12) << "MLP loss" << setw(12) << "static loss" << setw(8) << "result" << endl;
+    bool trainOk = checkTraining<double, 5, 16, 3>("double", 1e-12);
+    trainOk = checkTraining<double, 5, 20, 10, 3>("double", 1e-12) && trainOk;
+    trainOk = checkTraining<float, 5, 16, 3>("float", 1e-5) && trainOk;
+    trainOk = checkTraining<float, 5, 20, 10, 3>("float", 1e-5) && trainOk;
+    cout << (trainOk ? "StaticMLP trains like MLP." : "StaticMLP training diverges from MLP!") << endl;
+    return ok && trainOk ? 0 : 1;
+}
@@ -0,0 +1,350 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include "headers/MLP.h"
+#include "headers/SyntheticData.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Every heap allocation in the process goes through these, so each benchmark
+// can report how many allocations one operation makes.
+atomic<size_t> allocationCount{0};
+
+// All replacements are out of line so GCC never pairs an inlined malloc()
+// or free() with the other side of a new-expression and warns about a
+// mismatch.
+__attribute__((noinline)) void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(size_t size, align_val_t alignment) {
+    ++allocationCount;
+    const size_t align = size_t(alignment);
+    if (void* p = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, align_val_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+struct BenchOptions {
+    size_t repetitions = 11;
+    double repetitionSeconds = 0.01;
+    string filter;
+    string jsonPath;
+    string baselinePath;
+    double threshold = 0.10;
+};
+
+struct BenchResult {
+    string name;
+    size_t iterations = 0;
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double stddevNs = 0.0;
+    double minNs = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+// Calibrates an iteration count that fills one repetition, warms up for one
+// repetition, then times each repetition separately so the spread is real.
+BenchResult runBenchmark(const string& name, const BenchOptions& options, const function<void()>& op) {
+    BenchResult result;
+    result.name = name;
+
+    size_t iterations = 1;
+    while (true) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) op();
+        const double elapsed = chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed >= options.repetitionSeconds || iterations >= (size_t(1) << 30)) {
+            break;
+        }
+        iterations = elapsed > 0.0 ? max(iterations * 2, size_t(double(iterations) * options.repetitionSeconds / elapsed * 1.2)) : iterations * 2;
+    }
+    for (size_t i = 0; i < iterations; ++i) op();
+
+    // Reserved up front so recording a sample is never counted as one of
+    // the operation's allocations.
+    vector<double> samples;
+    samples.reserve(options.repetitions);
+    size_t allocations = 0;
+    for (size_t r = 0; r < options.repetitions; ++r) {
+        const size_t allocsBefore = allocationCount;
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) op();
+        samples.push_back(chrono::duration<double, nano>(Clock::now() - start).count() / double(iterations));
+        allocations += allocationCount - allocsBefore;
+    }
+
+    sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    result.iterations = iterations;
+    result.medianNs = n % 2 == 1 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    result.minNs = samples.front();
+    for (double s : samples) result.meanNs += s / double(n);
+    for (double s : samples) result.stddevNs += (s - result.meanNs) * (s - result.meanNs);
+    result.stddevNs = n > 1 ? sqrt(result.stddevNs / double(n - 1)) : 0.0;
+    result.allocsPerOp = double(allocations) / double(iterations * options.repetitions);
+    return result;
+}
+
+string resultJson(const BenchResult& r) {
+    ostringstream out;
+    out << setprecision(6) << "{\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations << ",\"median_ns\":" << r.medianNs << ",\"mean_ns\":" << r.meanNs << ",\"stddev_ns\":" << r.stddevNs << ",\"min_ns\":" << r.minNs << ",\"allocs_per_op\":" << r.allocsPerOp << "}";
+    return out.str();
+}
+
+// Reads the name and median of every result in a file written by
+// --json; each result sits on its own line.
+vector<pair<string, double>> loadBaseline(const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open baseline " + path);
+    }
+    vector<pair<string, double>> baseline;
+    string line;
+    while (getline(file, line)) {
+        const size_t name = line.find("\"name\":\"");
+        const size_t median = line.find("\"median_ns\":");
+        if (name == string::npos || median == string::npos) {
+            continue;
+        }
+        const size_t nameStart = name + 8;
+        baseline.emplace_back(line.substr(nameStart, line.find('"', nameStart) - nameStart), atof(line.c_str() + median + 12));
+    }
+    return baseline;
+}
+
+class BenchSuite {
+private:
+    BenchOptions options;
+    vector<BenchResult> results;
+
+public:
+    explicit BenchSuite(const BenchOptions& benchOptions) : options(benchOptions) {}
+
+    void add(const string& name, const function<void()>& op) {
+        if (!options.filter.empty() && name.find(options.filter) == string::npos) {
+            return;
+        }
+        BenchResult r = runBenchmark(name, options, op);
+        cout << left << setw(34) << r.name << right << fixed << setprecision(1)
+             << setw(14) << r.medianNs << setw(10) << (r.medianNs > 0.0 ? 100.0 * r.stddevNs / r.medianNs : 0.0) << "%"
+             << setw(14) << r.minNs << setw(12) << setprecision(2) << r.allocsPerOp << endl;
+        results.push_back(r);
+    }
+
+    void writeJson() const {
+        if (options.jsonPath.empty()) {
+            return;
+        }
+        ofstream file(options.jsonPath);
+        file << "{\"simd\":\"" << blas::simdLevelName(blas::simdLevel()) << "\",\"repetitions\":" << options.repetitions << ",\"results\":[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            file << resultJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "]}" << endl;
+        cout << "Results written to " << options.jsonPath << endl;
+    }
+
+    // Returns false when any benchmark's median is slower than the baseline
+    // by more than the threshold.
+    bool compare() const {
+        if (options.baselinePath.empty()) {
+            return true;
+        }
+        const vector<pair<string, double>> baseline = loadBaseline(options.baselinePath);
+        cout << endl << "Compared with " << options.baselinePath << " (threshold " << fixed << setprecision(0) << options.threshold * 100.0 << "%)" << endl;
+
+        bool ok = true;
+        for (const BenchResult& r : results) {
+            auto found = find_if(baseline.begin(), baseline.end(), [&](const pair<string, double>& b) { return b.first == r.name; });
+            if (found == baseline.end() || found->second <= 0.0) {
+                cout << left << setw(34) << r.name << "  (not in baseline)" << endl;
+                continue;
+            }
+            const double change = r.medianNs / found->second - 1.0;
+            const char* verdict = change > options.threshold ? "REGRESSION" : change < -options.threshold ? "improved" : "ok";
+            cout << left << setw(34) << r.name << right << setw(14) << setprecision(1) << found->second << setw(14) << r.medianNs
+                 << setw(9) << showpos << change * 100.0 << noshowpos << "%  " << verdict << endl;
+            ok = ok && change <= options.threshold;
+        }
+        return ok;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else if (arg == "--compare" && hasValue) options.baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) options.threshold = atof(argv[++i]) / 100.0;
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--reps" && hasValue) options.repetitions = max(1, atoi(argv[++i]));
+        else if (arg == "--min-time-ms" && hasValue) options.repetitionSeconds = atof(argv[++i]) / 1000.0;
+        else {
+            cerr << "Usage: " << argv[0] << " [--json FILE] [--compare BASELINE] [--threshold PCT] [--filter TEXT] [--reps N] [--min-time-ms MS]" << endl;
+            return 1;
+        }
+    }
+
+    cout << "Microbenchmarks (" << blas::simdLevelName(blas::simdLevel()) << " kernels, " << options.repetitions << " repetitions)" << endl;
+    cout << left << setw(34) << "Benchmark" << right << setw(14) << "median ns" << setw(11) << "stddev" << setw(14) << "min ns" << setw(12) << "allocs/op" << endl;
+
+    BenchSuite suite(options);
+
+    const size_t shapes[][3] = {{16, 5, 1}, {32, 32, 32}, {128, 128, 128}, {256, 64, 256}};
+    for (const auto& shape : shapes) {
+        auto a = make_shared<Matrix<double>>(shape[0], shape[1]);
+        auto b = make_shared<Matrix<double>>(shape[1], shape[2]);
+        a->randomize();
+        b->randomize();
+        suite.add("matmul/" + to_string(shape[0]) + "x" + to_string(shape[1]) + "x" + to_string(shape[2]), [a, b] {
+            Matrix<double> c = *a * *b;
+            asm volatile("" : : "r"(c.getData()) : "memory");
+        });
+    }
+
+    {
+        auto a = make_shared<Matrix<double>>(256, 256);
+        auto b = make_shared<Matrix<double>>(256, 256);
+        a->randomize();
+        b->randomize();
+        suite.add("add/256x256", [a, b] {
+            Matrix<double> c = *a + *b;
+            asm volatile("" : : "r"(c.getData()) : "memory");
+        });
+        suite.add("sub/256x256", [a, b] {
+            Matrix<double> c = *a - *b;
+            asm volatile("" : : "r"(c.getData()) : "memory");
+        });
+    }
+
+    for (size_t n : {size_t(64), size_t(4096)}) {
+        for (blas::SigmoidMode mode : {blas::SigmoidMode::Exact, blas::SigmoidMode::Fast}) {
+            auto values = make_shared<vector<double>>(n);
+            auto derivatives = make_shared<vector<double>>(n);
+            suite.add(string("sigmoid/") + (mode == blas::SigmoidMode::Exact ? "exact/" : "fast/") + to_string(n), [values, derivatives, n, mode] {
+                for (size_t i = 0; i < n; ++i) (*values)[i] = double(i % 17) * 0.5 - 4.0;
+                blas::sigmoid(n, values->data(), 0.0, derivatives->data(), mode);
+            });
+        }
+    }
+
+    // Seeded initialization of a 1024 x 1024 layer, single-threaded.
+    {
+        auto layer = make_shared<Matrix<double>>(1024, 1024);
+        suite.add("init/uniform/1024x1024", [layer] {
+            layer->randomize(-1.0, 1.0, 7);
+        });
+        suite.add("init/he-normal/1024x1024", [layer] {
+            initialParameters(InitConfig{InitScheme::HeNormal, 7}, 0, false, 1024, 1024, 0, layer->size(), layer->getData());
+        });
+    }
+
+    // One hidden layer's backward step, 64 wide with a 32-wide next layer
+    // and 32 samples: the separate product and Hadamard pass against the
+    // fused kernel.
+    {
+        const size_t width = 64, nextWidth = 32, batch = 32;
+        auto w = make_shared<Matrix<float>>(nextWidth, width);
+        auto nextDelta = make_shared<Matrix<float>>(nextWidth, batch);
+        auto derivative = make_shared<Matrix<float>>(width, batch);
+        auto delta = make_shared<Matrix<float>>(width, batch);
+        w->randomize();
+        nextDelta->randomize();
+        derivative->randomize();
+        suite.add("backprop/split/64x32x32f", [w, nextDelta, derivative, delta, width, batch, nextWidth] {
+            blas::gemmTN(width, batch, nextWidth, w->getData(), width, nextDelta->getData(), batch, delta->getData(), batch);
+            for (size_t i = 0; i < width * batch; ++i) delta->getData()[i] *= derivative->getData()[i];
+            asm volatile("" : : "r"(delta->getData()) : "memory");
+        });
+        suite.add("backprop/fused/64x32x32f", [w, nextDelta, derivative, delta, width, batch, nextWidth] {
+            blas::gemmTNHadamard(width, batch, nextWidth, w->getData(), width, nextDelta->getData(), batch, derivative->getData(), batch, delta->getData(), batch);
+            asm volatile("" : : "r"(delta->getData()) : "memory");
+        });
+    }
+
+    auto mlp = make_shared<MLP<double>>(vector<int>{5, 32, 3});
+    // A fixed seed so every run measures the same work.
+    Samples<double> samples = randomSamples<double>(1024, 5, 3, 7);
+    auto inputs = make_shared<vector<Matrix<double>>>(move(samples.inputs));
+    auto targets = make_shared<vector<Matrix<double>>>(move(samples.targets));
+    auto flatInputs = make_shared<vector<double>>(rowMajor(*inputs));
+    auto flatOutputs = make_shared<vector<double>>(inputs->size() * 3);
+
+    auto next = make_shared<size_t>(0);
+    suite.add("mlp/forward/5-32-3", [mlp, inputs, next] {
+        Matrix<double> y = mlp->forward((*inputs)[(*next)++ % inputs->size()]);
+        asm volatile("" : : "r"(y.getData()) : "memory");
+    });
+    suite.add("mlp/predict/5-32-3", [mlp, flatInputs, flatOutputs, next] {
+        const size_t row = (*next)++ % 1024;
+        mlp->predict(flatInputs->data() + row * 5, flatOutputs->data() + row * 3);
+    });
+    suite.add("mlp/predictBatch1024/5-32-3", [mlp, flatInputs, flatOutputs] {
+        mlp->predictBatch(flatInputs->data(), 1024, flatOutputs->data());
+    });
+    suite.add("mlp/trainEpoch1024/5-32-3", [mlp, inputs, targets] {
+        mlp->trainWithValidation(*inputs, *targets, *inputs, *targets, 1, false);
+    });
+    suite.add("mlp/evaluate1024/5-32-3", [mlp, inputs, targets] {
+        volatile double loss = mlp->evaluate(*inputs, *targets);
+        (void)loss;
+    });
+
+    // The 8-bit adder workload (headers/SyntheticData.h): generating 64K
+    // rows, and one float mini-batch epoch over 4096 of them.
+    {
+        SyntheticConfig adder;
+        adder.bits = 8;
+        adder.rows = 1 << 16;
+        adder.seed = 1;
+        auto features = make_shared<vector<float>>(adder.rows * syntheticInputs(adder));
+        auto labels = make_shared<vector<float>>(adder.rows * syntheticOutputs(adder));
+        suite.add("dataset/adder8/65536", [adder, features, labels] {
+            generateSynthetic(adder, 0, adder.rows, features->data(), labels->data());
+        });
+
+        adder.rows = 4096;
+        auto table = make_shared<CsvTable<float>>(makeSyntheticTable<float>(adder, 1));
+        auto model = make_shared<MLP<float>>(vector<int>{17, 64, 9}, 0.5f, 32, InitConfig{InitScheme::XavierUniform, 1});
+        model->setMiniBatches(true);
+        suite.add("mlp/trainEpoch4096/adder8-64f", [table, model] {
+            const MatrixView<const float> x(table->features.data(), table->rows, 17, 17);
+            const MatrixView<const float> y(table->labels.data(), table->rows, 9, 9);
+            model->trainWithValidation(x, y, MatrixView<const float>(nullptr, 0, 17, 17), MatrixView<const float>(nullptr, 0, 9, 9), 1, false);
+        });
+    }
+
+    suite.writeJson();
+    const bool ok = suite.compare();
+    if (!ok) {
+        cout << "Performance regression detected." << endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "headers/MLP.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Wall-clock time to a target test loss for each optimizer. Every trial
+// starts all candidates from the same random parameters; training runs in
+// chunks of checkEvery epochs and only the training time counts, not the
+// test-loss checks between chunks.
+
+struct Candidate {
+    string name;
+    OptimizerConfig optimizer;
+    double learningRate;
+    bool miniBatches;
+    size_t batchSize;
+};
+
+struct Outcome {
+    bool reached = false;
+    int epochs = 0;
+    double seconds = 0.0;
+};
+
+struct BenchOptions {
+    int trials = 5;
+    int maxEpochs = 5000;
+    int checkEvery = 10;
+};
+
+Outcome timeToTarget(const MLP<double>& initial, const Candidate& candidate, const Samples<double>& train, const Samples<double>& test, double targetLoss, const BenchOptions& options) {
+    MLP<double> mlp = initial;
+    mlp.setLearningRate(candidate.learningRate);
+    mlp.setBatchSize(candidate.batchSize);
+    mlp.setOptimizer(candidate.optimizer);
+    mlp.setMiniBatches(candidate.miniBatches);
+
+    Outcome outcome;
+    while (outcome.epochs < options.maxEpochs) {
+        auto start = Clock::now();
+        mlp.trainWithValidation(train.inputs, train.targets, test.inputs, test.targets, options.checkEvery, false);
+        outcome.seconds += chrono::duration<double>(Clock::now() - start).count();
+        outcome.epochs += options.checkEvery;
+        if (mlp.evaluate(test.inputs, test.targets) <= targetLoss) {
+            outcome.reached = true;
+            break;
+        }
+    }
+    return outcome;
+}
+
+template<typename V>
+V median(vector<V> values) {
+    sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void benchDataset(const string& name, const Samples<double>& train, const Samples<double>& test, const vector<int>& architecture, double targetLoss, const vector<Candidate>& candidates, const BenchOptions& options) {
+    cout << endl << name << ": " << architecture.size() - 2 << " hidden layer(s), " << train.inputs.size() << " train / " << test.inputs.size()
+         << " test samples, target test loss " << targetLoss << ", up to " << options.maxEpochs << " epochs" << endl;
+    cout << left << setw(24) << "Optimizer" << right << setw(8) << "LR" << setw(7) << "Batch" << setw(10) << "Reached"
+         << setw(10) << "Epochs" << setw(12) << "Time ms" << setw(10) << "Speedup" << endl;
+
+    vector<vector<Outcome>> outcomes(candidates.size());
+    for (int trial = 0; trial < options.trials; ++trial) {
+        const MLP<double> initial(architecture);
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            outcomes[c].push_back(timeToTarget(initial, candidates[c], train, test, targetLoss, options));
+        }
+    }
+
+    // Medians over every trial, counting a miss as the full budget, so an
+    // optimizer that rarely converges cannot look fast.
+    double baselineMs = 0.0;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        vector<int> epochs;
+        vector<double> milliseconds;
+        int reached = 0;
+        for (const Outcome& outcome : outcomes[c]) {
+            reached += outcome.reached ? 1 : 0;
+            epochs.push_back(outcome.epochs);
+            milliseconds.push_back(outcome.seconds * 1e3);
+        }
+        const double ms = median(milliseconds);
+        if (c == 0) {
+            baselineMs = ms;
+        }
+        const Candidate& candidate = candidates[c];
+        cout << left << setw(24) << candidate.name << right << setw(8) << candidate.learningRate << setw(7) << (candidate.miniBatches ? to_string(candidate.batchSize) : string("full"))
+             << setw(6) << reached << "/" << left << setw(3) << options.trials << right << setw(10) << median(epochs)
+             << fixed << setprecision(2) << setw(12) << ms << setw(9) << baselineMs / ms << "x" << defaultfloat << endl;
+    }
+}
+
+OptimizerConfig optimizerConfig(OptimizerKind kind, LearningRateSchedule schedule = LearningRateSchedule::Constant) {
+    OptimizerConfig config;
+    config.kind = kind;
+    config.schedule = schedule;
+    config.decayEpochs = 1000;
+    config.minScale = 0.1;
+    return config;
+}
+
+// Learning rates were tuned per optimizer on these datasets; the first row is
+// the plain full-batch descent the experiment configs use.
+vector<Candidate> candidates(double sgdRate, double momentumRate, double miniBatchMomentumRate, double adamRate, double miniBatchAdamRate, size_t miniBatch) {
+    const OptimizerConfig sgd = optimizerConfig(OptimizerKind::SGD);
+    const OptimizerConfig momentum = optimizerConfig(OptimizerKind::Momentum);
+    const OptimizerConfig nesterov = optimizerConfig(OptimizerKind::Nesterov);
+    const OptimizerConfig adam = optimizerConfig(OptimizerKind::Adam);
+    const OptimizerConfig adamCosine = optimizerConfig(OptimizerKind::Adam, LearningRateSchedule::Cosine);
+    return {
+        {"sgd (baseline)", sgd, sgdRate, false, 32},
+        {"sgd mini-batch", sgd, sgdRate, true, miniBatch},
+        {"momentum", momentum, momentumRate, false, 32},
+        {"momentum mini-batch", momentum, miniBatchMomentumRate, true, miniBatch},
+        {"nesterov mini-batch", nesterov, miniBatchMomentumRate, true, miniBatch},
+        {"adam", adam, adamRate, false, 32},
+        {"adam mini-batch", adam, miniBatchAdamRate, true, miniBatch},
+        {"adam cosine mini-batch", adamCosine, miniBatchAdamRate, true, miniBatch},
+    };
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--trials") == 0 && hasValue) {
+            options.trials = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--max-epochs") == 0 && hasValue) {
+            options.maxEpochs = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--check-every") == 0 && hasValue) {
+            options.checkEvery = max(1, atoi(argv[++i]));
+        } else {
+            cerr << "Usage: " << argv[0] << " [--trials N] [--max-epochs N] [--check-every N]" << endl;
+            return 1;
+        }
+    }
+
+    cout << "Time to target test loss, median of " << options.trials << " trials from shared random starts" << endl;
+
+    // Both datasets are complete truth tables, and a held-out slice of one
+    // says nothing about the optimizer (the adder never generalizes to rows
+    // it has not seen), so each trains and tests on the whole table.
+    const Samples<double> xorData = loadSamples<double>("datasets/xor_dataset.csv", {{"x1", "x2"}, {"y"}});
+    benchDataset("XOR", xorData, xorData, {2, 8, 1}, 0.01, candidates(0.5, 0.5, 0.1, 0.05, 0.02, 2), options);
+
+    const Samples<double> adderData = loadAdderSamples();
+    benchDataset("Binary Adder", adderData, adderData, {5, 16, 3}, 0.02, candidates(0.3, 0.3, 0.09, 0.05, 0.05, 4), options);
+    return 0;
+}
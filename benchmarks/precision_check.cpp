@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "headers/MLP.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Validates float32 training against the double path: both precisions start
+// from the same parameters, train on the same data, and must converge to
+// the same accuracy with closely matching loss. Also reports training
+// throughput of each precision.
+
+template<typename To, typename From>
+Matrix<To> convert(const Matrix<From>& source) {
+    Matrix<To> result(source.getRows(), source.getCols());
+    for (size_t i = 0; i < source.size(); ++i) {
+        result.getData()[i] = To(source.getData()[i]);
+    }
+    return result;
+}
+
+template<typename To, typename From>
+Samples<To> convert(const Samples<From>& source) {
+    Samples<To> result;
+    for (size_t i = 0; i < source.inputs.size(); ++i) {
+        result.inputs.push_back(convert<To>(source.inputs[i]));
+        result.targets.push_back(convert<To>(source.targets[i]));
+    }
+    return result;
+}
+
+// A float model with exactly the parameters of a double one, rounded.
+MLP<float> toFloat(const MLP<double>& model) {
+    MLP<float> result(model.getLayerSizes(), float(model.getLearningRate()), model.getBatchSize());
+    for (size_t i = 0; i + 1 < model.getLayerSizes().size(); ++i) {
+        result.setParameters(i, convert<float>(model.getWeights(i)), convert<float>(model.getBiases(i)));
+    }
+    return result;
+}
+
+template<typename T>
+double trainSeconds(MLP<T>& model, const Samples<T>& data, int epochs) {
+    auto start = Clock::now();
+    model.trainWithValidation(data.inputs, data.targets, data.inputs, data.targets, epochs, false);
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Config {
+    vector<int> architecture;
+    double learningRate;
+    int epochs;
+    size_t batchSize;
+};
+
+bool validate(const string& name, const Samples<double>& data, const vector<Config>& configs) {
+    const Samples<float> floatData = convert<float>(data);
+    bool ok = true;
+    for (const Config& config : configs) {
+        MLP<double> reference(config.architecture, config.learningRate, config.batchSize);
+        MLP<float> candidate = toFloat(reference);
+
+        const double doubleSeconds = trainSeconds(reference, data, config.epochs);
+        const double floatSeconds = trainSeconds(candidate, floatData, config.epochs);
+
+        const double doubleLoss = reference.evaluate(data.inputs, data.targets);
+        const double floatLoss = candidate.evaluate(floatData.inputs, floatData.targets);
+        const double doubleAccuracy = reference.calculateAccuracy(data.inputs, data.targets);
+        const double floatAccuracy = candidate.calculateAccuracy(floatData.inputs, floatData.targets);
+        const bool match = doubleAccuracy == floatAccuracy && fabs(doubleLoss - floatLoss) <= 1e-3 + 1e-2 * doubleLoss;
+        ok = ok && match;
+
+        string arch;
+        for (size_t i = 0; i < config.architecture.size(); ++i) {
+            arch += to_string(config.architecture[i]) + (i + 1 < config.architecture.size() ? "-" : "");
+        }
+        cout << left << setw(14) << name << setw(14) << arch << right << setw(7) << config.epochs
+             << fixed << setprecision(6) << setw(12) << doubleLoss << setw(12) << floatLoss
+             << setprecision(3) << setw(9) << doubleAccuracy << setw(9) << floatAccuracy
+             << setprecision(2) << setw(9) << doubleSeconds / floatSeconds << "x" << setw(8) << (match ? "ok" : "DIFF") << endl;
+    }
+    return ok;
+}
+
+int main() {
+    cout << "float32 training against double (" << blas::simdLevelName(blas::simdLevel()) << " kernels)" << endl;
+    cout << left << setw(14) << "Dataset" << setw(14) << "Network" << right << setw(7) << "Epochs" << setw(12) << "double loss" << setw(12) << "float loss"
+         << setw(9) << "dbl acc" << setw(9) << "flt acc" << setw(10) << "speedup" << setw(8) << "match" << endl;
+
+    const Samples<double> xorData = loadSamples<double>("datasets/xor_dataset.csv", {{"x1", "x2"}, {"y"}});
+    const Samples<double> adderData = loadAdderSamples();
+
+    bool ok = validate("XOR", xorData, {{{2, 4, 1}, 0.5, 1000, 32}, {{2, 8, 1}, 0.5, 2000, 32}, {{2, 8, 4, 1}, 0.2, 1500, 32}, {{2, 8, 1}, 2.0, 3000, 1}});
+    ok = validate("Binary Adder", adderData, {{{5, 16, 3}, 0.3, 1000, 32}, {{5, 16, 8, 3}, 0.15, 1500, 32}, {{5, 20, 10, 3}, 0.1, 2000, 32}, {{5, 16, 3}, 2.0, 3000, 8}}) && ok;
+
+    // Throughput at a size where GEMMs dominate.
+    Samples<double> wide;
+    mt19937 rng(11);
+    for (size_t s = 0; s < 4096; ++s) {
+        Matrix<double> x(64, 1), y(10, 1);
+        for (size_t i = 0; i < 64; ++i) x(i, 0) = double(rng() % 2);
+        y(s % 10, 0) = 1.0;
+        wide.inputs.push_back(x);
+        wide.targets.push_back(y);
+    }
+    ok = validate("Synthetic", wide, {{{64, 256, 256, 10}, 0.1, 5, 64}}) && ok;
+
+    cout << (ok ? "float32 training matches the double path." : "float32 training DIFFERS from the double path!") << endl;
+    return ok ? 0 : 1;
+}
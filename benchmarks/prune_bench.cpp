@@ -0,0 +1,151 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "headers/Pruning.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Accuracy, speed and weight memory of magnitude-pruned models at 50, 75
+// and 90% sparsity, against the dense model they were pruned from.
+
+template<typename Fn>
+double nanosecondsPerRow(size_t rows, Fn fn) {
+    fn();
+    size_t calls = 0;
+    auto start = Clock::now();
+    do {
+        fn();
+        ++calls;
+    } while (Clock::now() - start < chrono::milliseconds(200));
+    return chrono::duration<double, nano>(Clock::now() - start).count() / double(calls * rows);
+}
+
+string architectureName(const vector<int>& architecture) {
+    string name;
+    for (size_t i = 0; i < architecture.size(); ++i) {
+        name += to_string(architecture[i]) + (i + 1 < architecture.size() ? "-" : "");
+    }
+    return name;
+}
+
+const double sparsities[] = {0.5, 0.75, 0.9};
+
+// Trains a dense binary adder, then prunes copies of it globally and per
+// layer, scoring each before and after fine-tuning.
+void accuracyReport(const vector<int>& architecture, int epochs, int fineTuneEpochs) {
+    const Samples<double> adder = loadAdderSamples();
+    const vector<Matrix<double>>& inputs = adder.inputs;
+    const vector<Matrix<double>>& targets = adder.targets;
+
+    MLP<double> dense(architecture, 2.0, 8);
+    dense.trainWithValidation(inputs, targets, inputs, targets, epochs, false);
+    const Metrics<double> baseline = dense.computeMetrics(inputs, targets);
+
+    cout << "Binary adder " << architectureName(architecture) << ", " << epochs << " epochs dense, " << fineTuneEpochs << " fine-tuning" << endl;
+    cout << left << setw(10) << "Sparsity" << setw(11) << "Mode" << right << setw(11) << "loss" << setw(9) << "acc"
+         << setw(12) << "tuned loss" << setw(11) << "tuned acc" << setw(11) << "KiB" << endl;
+    cout << left << setw(10) << "0%" << setw(11) << "dense" << right << fixed << setprecision(5) << setw(11) << baseline.loss
+         << setprecision(3) << setw(9) << baseline.accuracy << setw(12) << "" << setw(11) << ""
+         << setprecision(2) << setw(11) << double(dense.weightBytes()) / 1024.0 << endl;
+
+    for (double sparsity : sparsities) {
+        for (bool global : {true, false}) {
+            PruningConfig config;
+            config.sparsity = sparsity;
+            config.global = global;
+            config.fineTuneEpochs = fineTuneEpochs;
+
+            MLP<double> pruned = dense;
+            pruneByMagnitude(pruned, config);
+            const Metrics<double> before = pruned.computeMetrics(inputs, targets);
+            pruned.trainWithValidation(inputs, targets, inputs, targets, fineTuneEpochs, false);
+            const Metrics<double> after = pruned.computeMetrics(inputs, targets);
+
+            cout << left << setw(10) << (to_string(int(sparsity * 100)) + "%") << setw(11) << (global ? "global" : "per-layer")
+                 << right << setprecision(5) << setw(11) << before.loss << setprecision(3) << setw(9) << before.accuracy
+                 << setprecision(5) << setw(12) << after.loss << setprecision(3) << setw(11) << after.accuracy
+                 << setprecision(2) << setw(11) << double(pruned.weightBytes()) / 1024.0 << endl;
+        }
+    }
+    cout << defaultfloat << endl;
+}
+
+// Inference throughput of a random network pruned per layer, against the
+// dense model, through predictBatch and computeMetrics. The pruned model is
+// also scored with the CSR path turned off, so its outputs can be compared
+// with the dense kernel over the same zeroed weights.
+bool speedReport(const vector<int>& architecture) {
+    const size_t rows = 1024;
+    MLP<double> dense(architecture);
+    const size_t in = dense.inputSize();
+    const size_t out = dense.outputSize();
+
+    mt19937 rng(5);
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    vector<double> flatInputs(rows * in);
+    for (double& x : flatInputs) {
+        x = uniform(rng);
+    }
+    vector<Matrix<double>> inputs, targets;
+    for (size_t r = 0; r < rows; ++r) {
+        inputs.push_back(Matrix<double>(vector<double>(flatInputs.begin() + long(r * in), flatInputs.begin() + long((r + 1) * in))));
+        Matrix<double> target(out, 1);
+        target(r % out, 0) = 1.0;
+        targets.push_back(target);
+    }
+
+    vector<double> outputs(rows * out), reference(rows * out);
+    const double densePredict = nanosecondsPerRow(rows, [&] { dense.predictBatch(flatInputs.data(), rows, outputs.data()); });
+    const double denseMetrics = nanosecondsPerRow(rows, [&] { dense.computeMetrics(inputs, targets); });
+
+    cout << "Random " << architectureName(architecture) << ", " << rows << " rows" << endl;
+    cout << left << setw(10) << "Sparsity" << setw(8) << "Path" << right << setw(11) << "KiB" << setw(10) << "smaller"
+         << setw(14) << "predict ns" << setw(10) << "speedup" << setw(14) << "metrics ns" << setw(10) << "speedup" << setw(12) << "max diff" << endl;
+    cout << left << setw(10) << "0%" << setw(8) << "dense" << right << fixed << setprecision(1) << setw(11) << double(dense.weightBytes()) / 1024.0
+         << setw(9) << 1.0 << "x" << setw(14) << densePredict << setw(9) << 1.0 << "x" << setw(14) << denseMetrics << setw(9) << 1.0 << "x" << endl;
+
+    bool ok = true;
+    for (double sparsity : sparsities) {
+        PruningConfig config;
+        config.sparsity = sparsity;
+        config.global = false;
+        MLP<double> pruned = dense;
+        pruneByMagnitude(pruned, config);
+
+        const double predictNs = nanosecondsPerRow(rows, [&] { pruned.predictBatch(flatInputs.data(), rows, outputs.data()); });
+        const double metricsNs = nanosecondsPerRow(rows, [&] { pruned.computeMetrics(inputs, targets); });
+
+        MLP<double> densePath = pruned;
+        densePath.setSparseThreshold(2.0);
+        densePath.predictBatch(flatInputs.data(), rows, reference.data());
+        pruned.predictBatch(flatInputs.data(), rows, outputs.data());
+        double worst = 0.0;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            worst = max(worst, fabs(outputs[i] - reference[i]));
+        }
+        ok = ok && worst < 1e-9;
+
+        cout << left << setw(10) << (to_string(int(sparsity * 100)) + "%") << setw(8) << (pruned.isSparseLayer(0) ? "csr" : "dense")
+             << right << setprecision(1) << setw(11) << double(pruned.weightBytes()) / 1024.0 << setw(9) << double(dense.weightBytes()) / double(pruned.weightBytes()) << "x"
+             << setw(14) << predictNs << setw(9) << densePredict / predictNs << "x" << setw(14) << metricsNs << setw(9) << denseMetrics / metricsNs << "x"
+             << setw(12) << scientific << setprecision(1) << worst << fixed << endl;
+    }
+    cout << defaultfloat << endl;
+    return ok;
+}
+
+int main() {
+    cout << "Magnitude pruning (" << blas::simdLevelName(blas::simdLevel()) << " kernels, CSR above " << MLP<double>({1, 1}).getSparseThreshold() * 100 << "% sparsity)" << endl << endl;
+    accuracyReport({5, 32, 3}, 3000, 2000);
+
+    bool ok = speedReport({64, 256, 256, 10});
+    ok = speedReport({256, 512, 512, 10}) && ok;
+    cout << (ok ? "CSR outputs match the dense kernel." : "CSR outputs DIFFER from the dense kernel!") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "headers/QuantizedMLP.h"
+#include "benchmarks/Samples.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+template<typename Fn>
+double nanosecondsPerRow(size_t rows, Fn fn) {
+    fn();
+    size_t calls = 0;
+    auto start = Clock::now();
+    do {
+        fn();
+        ++calls;
+    } while (Clock::now() - start < chrono::milliseconds(200));
+    return chrono::duration<double, nano>(Clock::now() - start).count() / double(calls * rows);
+}
+
+// Accuracy and output error of the int8 model against the float model it
+// was quantized from, on the binary adder dataset.
+bool compareAccuracy() {
+    const Samples<double> adder = loadAdderSamples();
+    const vector<Matrix<double>>& inputs = adder.inputs;
+    const vector<Matrix<double>>& targets = adder.targets;
+
+    MLP<double> mlp({5, 16, 3}, 2.0, 8);
+    mlp.trainWithValidation(inputs, targets, inputs, targets, 3000, false);
+    const QuantizedMLP quantized = QuantizedMLP::quantize(mlp, inputs);
+
+    double worst = 0.0;
+    vector<double> expected(3), actual(3);
+    for (const Matrix<double>& x : inputs) {
+        mlp.predict(x.getData(), expected.data());
+        quantized.predict(x.getData(), actual.data());
+        for (size_t i = 0; i < 3; ++i) {
+            worst = max(worst, fabs(expected[i] - actual[i]));
+        }
+    }
+
+    const double floatAccuracy = mlp.calculateAccuracy(inputs, targets);
+    const double int8Accuracy = quantized.calculateAccuracy(inputs, targets);
+    cout << "Binary adder 5-16-3: float accuracy " << fixed << setprecision(3) << floatAccuracy << ", int8 accuracy " << int8Accuracy
+         << ", max output diff " << scientific << setprecision(2) << worst << endl;
+    return int8Accuracy >= floatAccuracy - 1e-9;
+}
+
+// Throughput and model size on random networks; also checks that the scalar
+// integer kernel and the SIMD one give identical outputs.
+bool benchNetwork(const vector<int>& architecture) {
+    MLP<double> mlp(architecture);
+    const size_t in = mlp.inputSize();
+    const size_t out = mlp.outputSize();
+    const size_t rows = 1024;
+
+    vector<Matrix<double>> calibration;
+    vector<double> inputs(rows * in);
+    mt19937 rng(7);
+    uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (double& x : inputs) {
+        x = uniform(rng);
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        calibration.push_back(Matrix<double>(vector<double>(inputs.begin() + long(r * in), inputs.begin() + long((r + 1) * in))));
+    }
+
+    const QuantizedMLP quantized = QuantizedMLP::quantize(mlp, calibration);
+    vector<float> floatInputs(inputs.begin(), inputs.end());
+    vector<double> doubleOutputs(rows * out);
+    vector<float> int8Outputs(rows * out), scalarOutputs(rows * out);
+
+    size_t floatBytes = 0;
+    for (size_t i = 0; i + 1 < architecture.size(); ++i) {
+        floatBytes += (mlp.getWeights(i).size() + mlp.getBiases(i).size()) * sizeof(double);
+    }
+
+    const double doubleNs = nanosecondsPerRow(rows, [&] { mlp.predictBatch(inputs.data(), rows, doubleOutputs.data()); });
+    const double int8Ns = nanosecondsPerRow(rows, [&] { quantized.predictBatch(floatInputs.data(), rows, int8Outputs.data()); });
+
+    const blas::SimdLevel level = blas::simdLevel();
+    blas::setSimdLevel(blas::SimdLevel::Scalar);
+    quantized.predictBatch(floatInputs.data(), rows, scalarOutputs.data());
+    blas::setSimdLevel(level);
+
+    double worst = 0.0;
+    for (size_t i = 0; i < doubleOutputs.size(); ++i) {
+        worst = max(worst, fabs(doubleOutputs[i] - double(int8Outputs[i])));
+    }
+    const bool identical = int8Outputs == scalarOutputs;
+
+    string arch;
+    for (size_t i = 0; i < architecture.size(); ++i) {
+        arch += to_string(architecture[i]) + (i + 1 < architecture.size() ? "-" : "");
+    }
+    cout << left << setw(18) << arch << right << fixed << setprecision(1)
+         << setw(12) << double(floatBytes) / 1024.0 << setw(12) << double(quantized.modelBytes()) / 1024.0
+         << setw(10) << double(floatBytes) / double(quantized.modelBytes()) << "x"
+         << setw(12) << doubleNs << setw(12) << int8Ns << setw(9) << doubleNs / int8Ns << "x"
+         << setw(12) << scientific << setprecision(1) << worst << setw(10) << (identical ? "yes" : "NO") << endl;
+    return identical;
+}
+
+int main() {
+    cout << "int8 kernels: " << blas::int8KernelName() << ", float kernels: " << blas::simdLevelName(blas::simdLevel()) << endl;
+    bool ok = compareAccuracy();
+
+    cout << endl << left << setw(18) << "Network" << right << setw(12) << "double KiB" << setw(12) << "int8 KiB" << setw(11) << "smaller"
+         << setw(12) << "double ns" << setw(12) << "int8 ns" << setw(10) << "speedup" << setw(12) << "max diff" << setw(10) << "scalar=" << endl;
+    ok = benchNetwork({5, 16, 3}) && ok;
+    ok = benchNetwork({64, 256, 256, 10}) && ok;
+    ok = benchNetwork({256, 512, 512, 10}) && ok;
+    ok = benchNetwork({784, 1024, 1024, 10}) && ok;
+    cout << (ok ? "int8 model matches float accuracy and SIMD matches scalar." : "int8 check FAILED") << endl;
+    return ok ? 0 : 1;
+}
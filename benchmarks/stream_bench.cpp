@@ -0,0 +1,176 @@
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "headers/CsvLoader.h"
+#include "headers/MLP.h"
+#include "headers/SyntheticData.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Streaming training against loading the whole set first. Checks that a
+// file-order stream trains exactly like the in-memory path, that shuffled
+// passes are deterministic permutations, and times both paths on the
+// 8-bit adder workload as CSV and binary.
+//   stream_bench [rows]
+
+const size_t inputs = 17;
+const size_t outputs = 9;
+const int epochs = 3;
+
+// Empty validation sets of the right widths: the loss is monitored on the
+// training set.
+const MatrixView<const float> noInputs(nullptr, 0, inputs, inputs);
+const MatrixView<const float> noTargets(nullptr, 0, outputs, outputs);
+
+double secondsSince(Clock::time_point start) {
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The standard training workload: a sampled 8-bit adder, 17 inputs and 9
+// outputs.
+SyntheticConfig workload(size_t rows) {
+    SyntheticConfig config;
+    config.task = SyntheticTask::Adder;
+    config.bits = 8;
+    config.rows = rows;
+    config.seed = 1;
+    return config;
+}
+
+MLP<float> makeModel() {
+    MLP<float> model({int(inputs), 64, int(outputs)}, 0.5f, 32, InitConfig{InitScheme::XavierUniform, 3});
+    return model;
+}
+
+bool sameParameters(const MLP<float>& a, const MLP<float>& b) {
+    for (size_t i = 0; i + 1 < a.getLayerSizes().size(); ++i) {
+        const Matrix<float>& wa = a.getWeights(i);
+        const Matrix<float>& wb = b.getWeights(i);
+        const Matrix<float>& ba = a.getBiases(i);
+        const Matrix<float>& bb = b.getBiases(i);
+        if (!equal(wa.getData(), wa.getData() + wa.size(), wb.getData()) || !equal(ba.getData(), ba.getData() + ba.size(), bb.getData())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Full-batch training through a file-order stream sums the same batches in
+// the same order as the in-memory path, so the models must be identical.
+bool checkMatchesInMemory(const string& binaryPath) {
+    BinaryDataset<float> dataset(binaryPath);
+    MLP<float> memory = makeModel();
+    memory.trainWithValidation(dataset.features(), dataset.labels(), noInputs, noTargets, epochs, false);
+
+    BinaryFileSource<float> source(binaryPath);
+    DataStream<float> stream(source, StreamConfig{256, 0, 2, 0});
+    MLP<float> streamed = makeModel();
+    streamed.trainWithValidation(stream, noInputs, noTargets, epochs, false);
+    return sameParameters(memory, streamed);
+}
+
+// Sample ids through a shuffled stream: every pass must be a permutation,
+// passes must differ, and a second stream with the same seed must agree.
+bool checkShuffle() {
+    const size_t rows = 10000;
+    vector<float> ids(rows), unused(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        ids[r] = float(r);
+    }
+    ViewSource<float> source(MatrixView<const float>(ids.data(), rows, 1, 1), MatrixView<const float>(unused.data(), rows, 1, 1));
+    auto pass = [&](DataStream<float>& stream, uint64_t epoch) {
+        vector<size_t> order;
+        stream.beginEpoch(epoch);
+        while (const StreamBatch<float>* batch = stream.next()) {
+            for (size_t r = 0; r < batch->rows; ++r) {
+                order.push_back(size_t(batch->inputs(r, 0)));
+            }
+        }
+        return order;
+    };
+
+    const StreamConfig config{64, 1000, 2, 9};
+    vector<vector<size_t>> passes;
+    {
+        DataStream<float> stream(source, config);
+        for (uint64_t epoch = 0; epoch < 3; ++epoch) {
+            passes.push_back(pass(stream, epoch));
+        }
+    }
+    DataStream<float> again(source, config);
+    const bool repeatable = pass(again, 1) == passes[1];
+
+    bool permutations = true;
+    for (const vector<size_t>& order : passes) {
+        vector<size_t> sorted = order;
+        sort(sorted.begin(), sorted.end());
+        for (size_t r = 0; r < rows; ++r) {
+            permutations = permutations && sorted.size() == rows && sorted[r] == r;
+        }
+    }
+    return permutations && repeatable && passes[0] != passes[1];
+}
+
+void report(const string& name, double firstStep, double total, double stall, size_t bufferedRows) {
+    cout << left << setw(34) << name << right << fixed << setprecision(3) << setw(12) << firstStep << setw(10) << total
+         << setw(10) << stall << setw(14) << bufferedRows * (inputs + outputs) * sizeof(float) / 1024 << endl;
+}
+
+int main(int argc, char* argv[]) {
+    const size_t rows = argc > 1 ? size_t(max(1000, atoi(argv[1]))) : 200000;
+    const string csvPath = "stream_bench.csv";
+    const string binaryPath = "stream_bench.bin";
+    writeSyntheticCsv(workload(rows), csvPath);
+    writeSyntheticBinary<float>(workload(rows), binaryPath);
+
+    const bool matches = checkMatchesInMemory(binaryPath);
+    const bool shuffles = checkShuffle();
+    cout << "File-order stream matches in-memory training: " << (matches ? "yes" : "NO") << endl;
+    cout << "Shuffled passes are repeatable permutations: " << (shuffles ? "yes" : "NO") << endl << endl;
+
+    cout << rows << " rows of 8-bit adder, " << inputs << "-64-" << outputs << " float, " << epochs << " mini-batch epochs" << endl;
+    cout << left << setw(34) << "Path" << right << setw(12) << "first step" << setw(10) << "total s" << setw(10) << "stall s" << setw(14) << "buffer KiB" << endl;
+
+    // Load everything, then train: the first step waits for the whole parse.
+    {
+        const auto start = Clock::now();
+        CsvTable<float> table = loadCsv<float>(csvPath, syntheticColumns(workload(rows)));
+        const MatrixView<const float> features(table.features.data(), table.rows, inputs, inputs);
+        const MatrixView<const float> labels(table.labels.data(), table.rows, outputs, outputs);
+        const double loaded = secondsSince(start);
+        MLP<float> model = makeModel();
+        model.setMiniBatches(true, 9);
+        model.trainWithValidation(features, labels, noInputs, noTargets, epochs, false);
+        report("CSV, load then train", loaded, secondsSince(start), 0.0, table.rows);
+    }
+
+    const StreamConfig config{32, 4096, 2, 9};
+    auto streamed = [&](const string& name, DataSource<float>& source) {
+        const auto start = Clock::now();
+        DataStream<float> stream(source, config);
+        stream.beginEpoch(0);
+        stream.next();
+        const double firstBatch = secondsSince(start);
+        MLP<float> model = makeModel();
+        model.setMiniBatches(true);
+        model.trainWithValidation(stream, noInputs, noTargets, epochs, false);
+        report(name, firstBatch, secondsSince(start), stream.stallSeconds(), config.shuffleWindow + (config.queueDepth + 2) * config.batchRows);
+    };
+    {
+        CsvFileSource<float> source(csvPath, syntheticColumns(workload(rows)));
+        streamed("CSV, streamed", source);
+    }
+    {
+        BinaryFileSource<float> source(binaryPath);
+        streamed("Binary, streamed", source);
+    }
+
+    remove(csvPath.c_str());
+    remove(binaryPath.c_str());
+    return matches && shuffles ? 0 : 1;
+}
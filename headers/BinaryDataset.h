@@ -0,0 +1,135 @@
+#ifndef BINARY_DATASET_H
+#define BINARY_DATASET_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Matrix.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// On-disk layout (native byte order):
+//   64-byte BinaryDatasetHeader
+//   features: rows x inputDim values, row-major, at featureOffset
+//   labels:   rows x outputDim values, row-major, at labelOffset
+// Both blocks start on a 64-byte boundary, so once the file is mapped they
+// can be used in place as aligned matrix views.
+enum class DatasetType : uint32_t { Float32 = 1, Float64 = 2 };
+
+struct BinaryDatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t rows;
+    uint64_t inputDim;
+    uint64_t outputDim;
+    uint64_t featureOffset;
+    uint64_t labelOffset;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(BinaryDatasetHeader) == 64, "Dataset header must stay 64 bytes");
+
+constexpr char BINARY_DATASET_MAGIC[8] = {'M', 'L', 'P', 'D', 'A', 'T', 'A', '\0'};
+constexpr uint32_t BINARY_DATASET_VERSION = 1;
+constexpr uint64_t BINARY_DATASET_ALIGNMENT = 64;
+
+template<typename T>
+constexpr DatasetType datasetTypeOf() {
+    static_assert(is_same<T, float>::value || is_same<T, double>::value, "Binary datasets hold float or double");
+    return is_same<T, float>::value ? DatasetType::Float32 : DatasetType::Float64;
+}
+
+inline uint64_t alignDatasetOffset(uint64_t offset) {
+    return (offset + BINARY_DATASET_ALIGNMENT - 1) / BINARY_DATASET_ALIGNMENT * BINARY_DATASET_ALIGNMENT;
+}
+
+// The header for a file of rows samples, with the block offsets filled in.
+template<typename T>
+BinaryDatasetHeader binaryDatasetHeader(size_t rows, size_t inputDim, size_t outputDim) {
+    BinaryDatasetHeader header{};
+    memcpy(header.magic, BINARY_DATASET_MAGIC, sizeof(header.magic));
+    header.version = BINARY_DATASET_VERSION;
+    header.dtype = uint32_t(datasetTypeOf<T>());
+    header.rows = rows;
+    header.inputDim = inputDim;
+    header.outputDim = outputDim;
+    header.featureOffset = alignDatasetOffset(sizeof(BinaryDatasetHeader));
+    header.labelOffset = alignDatasetOffset(header.featureOffset + rows * inputDim * sizeof(T));
+    return header;
+}
+
+template<typename T>
+void writeBinaryDataset(const string& path, const T* features, const T* labels, size_t rows, size_t inputDim, size_t outputDim) {
+    const BinaryDatasetHeader header = binaryDatasetHeader<T>(rows, inputDim, outputDim);
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open file " + path);
+    }
+
+    const char padding[BINARY_DATASET_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, streamsize(header.featureOffset - sizeof(header)));
+    file.write(reinterpret_cast<const char*>(features), streamsize(rows * inputDim * sizeof(T)));
+    file.write(padding, streamsize(header.labelOffset - header.featureOffset - rows * inputDim * sizeof(T)));
+    file.write(reinterpret_cast<const char*>(labels), streamsize(rows * outputDim * sizeof(T)));
+    if (!file) {
+        throw runtime_error("Failed writing " + path);
+    }
+}
+
+// A dataset file mapped read-only. features() and labels() point into the
+// mapping, so opening costs a header check regardless of size and the data
+// is shared page cache rather than a private heap copy.
+template<typename T>
+class BinaryDataset {
+private:
+    MappedFile file;
+    BinaryDatasetHeader header;
+
+    const T* block(uint64_t offset) const {
+        return reinterpret_cast<const T*>(file.data() + offset);
+    }
+
+public:
+    explicit BinaryDataset(const string& path) : file(path) {
+        if (file.size() < sizeof(BinaryDatasetHeader)) {
+            throw runtime_error("Truncated dataset file " + path);
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, BINARY_DATASET_MAGIC, sizeof(header.magic)) != 0) {
+            throw runtime_error("Not a binary dataset file: " + path);
+        }
+        if (header.version != BINARY_DATASET_VERSION) {
+            throw runtime_error("Unsupported dataset version in " + path);
+        }
+        if (header.dtype != uint32_t(datasetTypeOf<T>())) {
+            throw runtime_error("Dataset element type does not match in " + path);
+        }
+        if (header.featureOffset % BINARY_DATASET_ALIGNMENT != 0 || header.labelOffset % BINARY_DATASET_ALIGNMENT != 0 ||
+            header.featureOffset + header.rows * header.inputDim * sizeof(T) > header.labelOffset ||
+            header.labelOffset + header.rows * header.outputDim * sizeof(T) > file.size()) {
+            throw runtime_error("Corrupt dataset layout in " + path);
+        }
+    }
+
+    size_t rows() const { return size_t(header.rows); }
+    size_t inputDim() const { return size_t(header.inputDim); }
+    size_t outputDim() const { return size_t(header.outputDim); }
+
+    MatrixView<const T> features() const {
+        return MatrixView<const T>(block(header.featureOffset), rows(), inputDim(), inputDim());
+    }
+
+    MatrixView<const T> labels() const {
+        return MatrixView<const T>(block(header.labelOffset), rows(), outputDim(), outputDim());
+    }
+};
+
+#endif // BINARY_DATASET_H
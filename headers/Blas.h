@@ -0,0 +1,558 @@
+#ifndef BLAS_H
+#define BLAS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLAS_X86 1
+#include <immintrin.h>
+#else
+#define BLAS_X86 0
+#endif
+
+using namespace std;
+
+// Dense row-major GEMM/GEMV and sigmoid kernels behind Matrix and MLP. float
+// and double go through AVX-512 or AVX2 kernels picked at runtime from the
+// host CPU; every other element type (and non-x86 builds) uses the scalar path.
+namespace blas {
+
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+inline SimdLevel detectSimdLevel() {
+#if BLAS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+// The active level starts at the best the CPU supports, lowered by the
+// BLAS_SIMD environment variable (scalar, avx2, avx512) when set.
+inline SimdLevel& activeSimdLevel() {
+    static SimdLevel level = [] {
+        SimdLevel detected = detectSimdLevel();
+        const char* requested = getenv("BLAS_SIMD");
+        if (requested != nullptr) {
+            SimdLevel wanted = detected;
+            if (strcmp(requested, "scalar") == 0) wanted = SimdLevel::Scalar;
+            else if (strcmp(requested, "avx2") == 0) wanted = SimdLevel::AVX2;
+            else if (strcmp(requested, "avx512") == 0) wanted = SimdLevel::AVX512;
+            if (wanted < detected) detected = wanted;
+        }
+        return detected;
+    }();
+    return level;
+}
+
+inline SimdLevel simdLevel() {
+    return activeSimdLevel();
+}
+
+// Requests a kernel level; anything the CPU cannot run is clamped down.
+inline SimdLevel setSimdLevel(SimdLevel level) {
+    SimdLevel detected = detectSimdLevel();
+    activeSimdLevel() = level < detected ? level : detected;
+    return activeSimdLevel();
+}
+
+namespace scalar {
+
+template<typename T>
+inline void gemm(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc) {
+    constexpr size_t KC = 256;
+    for (size_t pc = 0; pc < K; pc += KC) {
+        const size_t kEnd = K - pc < KC ? K : pc + KC;
+        for (size_t i = 0; i < M; ++i) {
+            T* cRow = C + i * ldc;
+            for (size_t k = pc; k < kEnd; ++k) {
+                const T a = A[i * lda + k];
+                const T* bRow = B + k * ldb;
+                for (size_t j = 0; j < N; ++j) {
+                    cRow[j] += a * bRow[j];
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+inline void gemv(size_t M, size_t N, const T* A, size_t lda, const T* x, T* y, const T* scale) {
+    for (size_t i = 0; i < M; ++i) {
+        const T* a = A + i * lda;
+        T sum = T{};
+        for (size_t j = 0; j < N; ++j) {
+            sum += a[j] * x[j];
+        }
+        y[i] = scale != nullptr ? sum * scale[i] : sum;
+    }
+}
+
+template<typename T>
+inline void ger(size_t M, size_t N, const T* x, const T* y, T* A, size_t lda) {
+    for (size_t i = 0; i < M; ++i) {
+        T* a = A + i * lda;
+        for (size_t j = 0; j < N; ++j) {
+            a[j] += x[i] * y[j];
+        }
+    }
+}
+
+template<typename T>
+inline void gemmTN(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        T* cRow = C + i * ldc;
+        for (size_t k = 0; k < K; ++k) {
+            const T a = A[k * lda + i];
+            const T* bRow = B + k * ldb;
+            for (size_t j = 0; j < N; ++j) {
+                cRow[j] += a * bRow[j];
+            }
+        }
+    }
+}
+
+template<typename T>
+inline void gemmNT(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        const T* aRow = A + i * lda;
+        for (size_t j = 0; j < N; ++j) {
+            const T* bRow = B + j * ldb;
+            T sum = T{};
+            for (size_t k = 0; k < K; ++k) {
+                sum += aRow[k] * bRow[k];
+            }
+            C[i * ldc + j] += sum;
+        }
+    }
+}
+
+template<typename T>
+inline void gemmTNHadamard(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, const T* D, size_t ldd, T* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        T* cRow = C + i * ldc;
+        fill(cRow, cRow + N, T{});
+        for (size_t k = 0; k < K; ++k) {
+            const T a = A[k * lda + i];
+            const T* bRow = B + k * ldb;
+            for (size_t j = 0; j < N; ++j) {
+                cRow[j] += a * bRow[j];
+            }
+        }
+        const T* dRow = D + i * ldd;
+        for (size_t j = 0; j < N; ++j) {
+            cRow[j] *= dRow[j];
+        }
+    }
+}
+
+template<typename T>
+inline void spmm(size_t M, size_t N, const uint32_t* rowStart, const uint32_t* columns, const T* values, const T* B, size_t ldb, T* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        T* cRow = C + i * ldc;
+        fill(cRow, cRow + N, T{});
+        for (uint32_t p = rowStart[i]; p < rowStart[i + 1]; ++p) {
+            const T a = values[p];
+            const T* bRow = B + size_t(columns[p]) * ldb;
+            for (size_t j = 0; j < N; ++j) {
+                cRow[j] += a * bRow[j];
+            }
+        }
+    }
+}
+
+template<typename T>
+inline void sigmoid(size_t n, T* values, T bias, T* derivatives) {
+    for (size_t j = 0; j < n; ++j) {
+        const T s = T(1.0) / (T(1.0) + T(exp(-double(values[j] + bias))));
+        values[j] = s;
+        if (derivatives != nullptr) {
+            derivatives[j] = s * (T(1.0) - s);
+        }
+    }
+}
+
+} // namespace scalar
+
+// Range-reduction constants for the polynomial exp behind the SIMD sigmoid.
+// Inputs are clamped so 2^n stays a normal number.
+template<typename S> struct ExpConstants;
+
+template<> struct ExpConstants<double> {
+    static constexpr double clamp = 708.0;
+    static constexpr double log2e = 1.4426950408889634074;
+    static constexpr double ln2Hi = 6.93147180369123816490e-01;
+    static constexpr double ln2Lo = 1.90821492927058770002e-10;
+};
+
+template<> struct ExpConstants<float> {
+    static constexpr float clamp = 87.0f;
+    static constexpr float log2e = 1.44269504088896341f;
+    static constexpr float ln2Hi = 0.693359375f;
+    static constexpr float ln2Lo = -2.12194440e-4f;
+};
+
+template<typename S>
+constexpr S inverseFactorial(int k) {
+    S value = S(1);
+    for (int i = 2; i <= k; ++i) {
+        value /= S(i);
+    }
+    return value;
+}
+
+#if BLAS_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace avx2 {
+
+template<typename S> struct Vec;
+
+template<> struct Vec<double> {
+    using Reg = __m256d;
+    static constexpr size_t width = 4;
+    static Reg zero() { return _mm256_setzero_pd(); }
+    static Reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+    // Partial loads and stores touch only the first n < width lanes.
+    static __m256i laneMask(size_t n) { return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(n)), _mm256_setr_epi64x(0, 1, 2, 3)); }
+    static Reg loadPartial(const double* p, size_t n) { return _mm256_maskload_pd(p, laneMask(n)); }
+    static void storePartial(double* p, Reg v, size_t n) { _mm256_maskstore_pd(p, laneMask(n), v); }
+    static Reg set1(double x) { return _mm256_set1_pd(x); }
+    static Reg fmadd(Reg a, Reg b, Reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static Reg add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+    static Reg sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+    static Reg mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+    static Reg div(Reg a, Reg b) { return _mm256_div_pd(a, b); }
+    static Reg min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+    static Reg round(Reg v) { return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    // p * 2^n for integral n within the normal exponent range.
+    static Reg scale2(Reg p, Reg n) {
+        __m256i bits = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), 52);
+        return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(p), bits));
+    }
+    static double sum(Reg v) {
+        __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+};
+
+template<> struct Vec<float> {
+    using Reg = __m256;
+    static constexpr size_t width = 8;
+    static Reg zero() { return _mm256_setzero_ps(); }
+    static Reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+    static __m256i laneMask(size_t n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(int(n)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+    static Reg loadPartial(const float* p, size_t n) { return _mm256_maskload_ps(p, laneMask(n)); }
+    static void storePartial(float* p, Reg v, size_t n) { _mm256_maskstore_ps(p, laneMask(n), v); }
+    static Reg set1(float x) { return _mm256_set1_ps(x); }
+    static Reg fmadd(Reg a, Reg b, Reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    static Reg div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+    static Reg min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+    static Reg round(Reg v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static Reg scale2(Reg p, Reg n) {
+        __m256i bits = _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23);
+        return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), bits));
+    }
+    static float sum(Reg v) {
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+};
+
+#include "BlasKernels.h"
+
+} // namespace avx2
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+namespace avx512 {
+
+template<typename S> struct Vec;
+
+template<> struct Vec<double> {
+    using Reg = __m512d;
+    static constexpr size_t width = 8;
+    static Reg zero() { return _mm512_setzero_pd(); }
+    static Reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, Reg v) { _mm512_storeu_pd(p, v); }
+    static Reg loadPartial(const double* p, size_t n) { return _mm512_maskz_loadu_pd(__mmask8((1u << n) - 1), p); }
+    static void storePartial(double* p, Reg v, size_t n) { _mm512_mask_storeu_pd(p, __mmask8((1u << n) - 1), v); }
+    static Reg set1(double x) { return _mm512_set1_pd(x); }
+    static Reg fmadd(Reg a, Reg b, Reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static Reg add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    static Reg sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+    static Reg mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+    static Reg div(Reg a, Reg b) { return _mm512_div_pd(a, b); }
+    // The all-lanes mask forms avoid GCC 12's bogus -Wmaybe-uninitialized on
+    // the unmasked intrinsics.
+    static Reg min(Reg a, Reg b) { return _mm512_mask_min_pd(a, 0xFF, a, b); }
+    static Reg max(Reg a, Reg b) { return _mm512_mask_max_pd(a, 0xFF, a, b); }
+    static Reg round(Reg v) { return _mm512_mask_roundscale_pd(v, 0xFF, v, _MM_FROUND_TO_NEAREST_INT); }
+    static Reg scale2(Reg p, Reg n) { return _mm512_mask_scalef_pd(p, 0xFF, p, n); }
+    static double sum(Reg v) {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, v);
+        __m256d half = _mm256_add_pd(_mm256_load_pd(lanes), _mm256_load_pd(lanes + 4));
+        __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+};
+
+template<> struct Vec<float> {
+    using Reg = __m512;
+    static constexpr size_t width = 16;
+    static Reg zero() { return _mm512_setzero_ps(); }
+    static Reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, Reg v) { _mm512_storeu_ps(p, v); }
+    static Reg loadPartial(const float* p, size_t n) { return _mm512_maskz_loadu_ps(__mmask16((1u << n) - 1), p); }
+    static void storePartial(float* p, Reg v, size_t n) { _mm512_mask_storeu_ps(p, __mmask16((1u << n) - 1), v); }
+    static Reg set1(float x) { return _mm512_set1_ps(x); }
+    static Reg fmadd(Reg a, Reg b, Reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+    static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+    static Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+    static Reg div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+    static Reg min(Reg a, Reg b) { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+    static Reg max(Reg a, Reg b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+    static Reg round(Reg v) { return _mm512_mask_roundscale_ps(v, 0xFFFF, v, _MM_FROUND_TO_NEAREST_INT); }
+    static Reg scale2(Reg p, Reg n) { return _mm512_mask_scalef_ps(p, 0xFFFF, p, n); }
+    static float sum(Reg v) {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, v);
+        __m256 half = _mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8));
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+};
+
+#include "BlasKernels.h"
+
+} // namespace avx512
+#pragma GCC pop_options
+
+#endif // BLAS_X86
+
+template<typename T>
+constexpr bool hasSimdKernels() {
+    return BLAS_X86 && (is_same<T, double>::value || is_same<T, float>::value);
+}
+
+template<typename T>
+inline void zeroBlock(size_t M, size_t N, T* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        fill(C + i * ldc, C + i * ldc + N, T{});
+    }
+}
+
+// C = A * B, or C += A * B when accumulate is set. A is M x K, B is K x N and
+// C is M x N, all row-major with the given leading dimensions.
+template<typename T>
+inline void gemm(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc, bool accumulate = false) {
+    if (!accumulate) {
+        zeroBlock(M, N, C, ldc);
+    }
+
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemm<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            case SimdLevel::AVX2: avx2::gemm<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemm<T>(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+// y = A * x for a row-major M x N matrix A.
+template<typename T>
+inline void gemv(size_t M, size_t N, const T* A, size_t lda, const T* x, T* y) {
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemv<T>(M, N, A, lda, x, y, static_cast<const T*>(nullptr)); return;
+            case SimdLevel::AVX2: avx2::gemv<T>(M, N, A, lda, x, y, static_cast<const T*>(nullptr)); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemv<T>(M, N, A, lda, x, y, static_cast<const T*>(nullptr));
+}
+
+// y = (A * x) .* d: one layer of single-sample backpropagation when A holds
+// a weight matrix's transpose row-major, x the next layer's deltas and d the
+// activation derivatives.
+template<typename T>
+inline void gemvHadamard(size_t M, size_t N, const T* A, size_t lda, const T* x, const T* d, T* y) {
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemv<T>(M, N, A, lda, x, y, d); return;
+            case SimdLevel::AVX2: avx2::gemv<T>(M, N, A, lda, x, y, d); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemv<T>(M, N, A, lda, x, y, d);
+}
+
+// A += x * y^T for a row-major M x N A: one sample's weight-gradient update.
+template<typename T>
+inline void ger(size_t M, size_t N, const T* x, const T* y, T* A, size_t lda) {
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::ger<T>(M, N, x, y, A, lda); return;
+            case SimdLevel::AVX2: avx2::ger<T>(M, N, x, y, A, lda); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::ger<T>(M, N, x, y, A, lda);
+}
+
+// C = A^T * B (or +=) where A is stored K x M, B is K x N and C is M x N.
+template<typename T>
+inline void gemmTN(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc, bool accumulate = false) {
+    if (!accumulate) {
+        zeroBlock(M, N, C, ldc);
+    }
+
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemmTN<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            case SimdLevel::AVX2: avx2::gemmTN<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemmTN<T>(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+// C = (A^T * B) .* D where A is stored K x M, and B is K x N and D and C are
+// M x N: a batch of backpropagated deltas, W^T * delta times s'(z), in one
+// pass that never rereads C.
+template<typename T>
+inline void gemmTNHadamard(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, const T* D, size_t ldd, T* C, size_t ldc) {
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemmTNHadamard<T>(M, N, K, A, lda, B, ldb, D, ldd, C, ldc); return;
+            case SimdLevel::AVX2: avx2::gemmTNHadamard<T>(M, N, K, A, lda, B, ldb, D, ldd, C, ldc); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemmTNHadamard<T>(M, N, K, A, lda, B, ldb, D, ldd, C, ldc);
+}
+
+// C = A * B where A is an M-row CSR matrix (row i's entries are
+// [rowStart[i], rowStart[i + 1]) of columns and values) and B is dense with
+// one row per column of A. C is overwritten.
+template<typename T>
+inline void spmm(size_t M, size_t N, const uint32_t* rowStart, const uint32_t* columns, const T* values, const T* B, size_t ldb, T* C, size_t ldc) {
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::spmm<T>(M, N, rowStart, columns, values, B, ldb, C, ldc); return;
+            case SimdLevel::AVX2: avx2::spmm<T>(M, N, rowStart, columns, values, B, ldb, C, ldc); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::spmm<T>(M, N, rowStart, columns, values, B, ldb, C, ldc);
+}
+
+// C = A * B^T (or +=) where A is M x K, B is stored N x K and C is M x N.
+template<typename T>
+inline void gemmNT(size_t M, size_t N, size_t K, const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc, bool accumulate = false) {
+    if (!accumulate) {
+        zeroBlock(M, N, C, ldc);
+    }
+
+#if BLAS_X86
+    if constexpr (hasSimdKernels<T>()) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: avx512::gemmNT<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            case SimdLevel::AVX2: avx2::gemmNT<T>(M, N, K, A, lda, B, ldb, C, ldc); return;
+            default: break;
+        }
+    }
+#endif
+    scalar::gemmNT<T>(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+// Accuracy mode of the SIMD sigmoid. Exact evaluates e^r with a degree-12
+// (double) or degree-7 (float) polynomial; its max absolute error against the
+// true sigmoid is 1.7e-16 / 9e-8, i.e. rounding level. Fast drops to degree
+// 6 / 4 for a max error of 4e-8 / 1.4e-5. Scalar fallbacks always call exp()
+// and ignore the mode.
+enum class SigmoidMode { Exact, Fast };
+
+template<typename S> struct SigmoidDegree;
+template<> struct SigmoidDegree<double> { static constexpr int exact = 12, fast = 6; };
+template<> struct SigmoidDegree<float> { static constexpr int exact = 7, fast = 4; };
+
+// values[j] = 1 / (1 + e^-(values[j] + bias)); when derivatives is non-null it
+// also receives s * (1 - s), computed in the same pass.
+template<typename T>
+inline void sigmoid(size_t n, T* values, T bias, T* derivatives, SigmoidMode mode = SigmoidMode::Exact) {
+#if BLAS_X86
+    // A handful of independent libm calls overlap better than one serial
+    // polynomial chain, so very short rows stay scalar.
+    if constexpr (hasSimdKernels<T>()) {
+        if (n < 4) {
+            scalar::sigmoid<T>(n, values, bias, derivatives);
+            return;
+        }
+        constexpr int exact = SigmoidDegree<T>::exact;
+        constexpr int fast = SigmoidDegree<T>::fast;
+        const bool useFast = mode == SigmoidMode::Fast;
+        switch (simdLevel()) {
+            case SimdLevel::AVX512:
+                useFast ? avx512::sigmoid<T, fast>(n, values, bias, derivatives) : avx512::sigmoid<T, exact>(n, values, bias, derivatives);
+                return;
+            case SimdLevel::AVX2:
+                useFast ? avx2::sigmoid<T, fast>(n, values, bias, derivatives) : avx2::sigmoid<T, exact>(n, values, bias, derivatives);
+                return;
+            default: break;
+        }
+    }
+#endif
+    scalar::sigmoid<T>(n, values, bias, derivatives);
+}
+
+} // namespace blas
+
+#endif // BLAS_H
@@ -0,0 +1,177 @@
+#ifndef BLAS_INT8_H
+#define BLAS_INT8_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Blas.h"
+
+using namespace std;
+
+// Integer GEMM for quantized inference: unsigned 8-bit activations times
+// signed 8-bit weights, accumulated in int32. Activations must stay within
+// 0..127 so that the AVX2 maddubs pair sums (2 * 127 * 127) never saturate
+// int16; with that, every path returns bit-identical results.
+namespace blas {
+
+namespace scalar {
+
+inline void gemmU8S8(size_t M, size_t N, size_t K, const uint8_t* A, size_t lda, const int8_t* B, size_t ldb, int32_t* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            int32_t sum = 0;
+            for (size_t k = 0; k < K; ++k) {
+                sum += int32_t(A[i * lda + k]) * int32_t(B[j * ldb + k]);
+            }
+            C[i * ldc + j] = sum;
+        }
+    }
+}
+
+} // namespace scalar
+
+#if BLAS_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace avx2 {
+
+inline int32_t horizontalSum(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// K must be a multiple of 32. Four weight rows share each activation load.
+inline void gemmU8S8(size_t M, size_t N, size_t K, const uint8_t* A, size_t lda, const int8_t* B, size_t ldb, int32_t* C, size_t ldc) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (size_t i = 0; i < M; ++i) {
+        const uint8_t* a = A + i * lda;
+        size_t j = 0;
+        for (; j + 4 <= N; j += 4) {
+            __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t k = 0; k < K; k += 32) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k));
+                acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + (j + 0) * ldb + k))), ones));
+                acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + (j + 1) * ldb + k))), ones));
+                acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + (j + 2) * ldb + k))), ones));
+                acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + (j + 3) * ldb + k))), ones));
+            }
+            C[i * ldc + j + 0] = horizontalSum(acc0);
+            C[i * ldc + j + 1] = horizontalSum(acc1);
+            C[i * ldc + j + 2] = horizontalSum(acc2);
+            C[i * ldc + j + 3] = horizontalSum(acc3);
+        }
+        for (; j < N; ++j) {
+            __m256i acc = _mm256_setzero_si256();
+            for (size_t k = 0; k < K; k += 32) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B + j * ldb + k))), ones));
+            }
+            C[i * ldc + j] = horizontalSum(acc);
+        }
+    }
+}
+
+} // namespace avx2
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vnni,avx2,fma")
+namespace avx512 {
+
+// Stored and summed rather than _mm512_reduce_add_epi32, which trips a GCC 12
+// maybe-uninitialized false positive.
+inline int32_t horizontalSum(__m512i v) {
+    alignas(64) int32_t lanes[16];
+    _mm512_store_si512(lanes, v);
+    int32_t sum = 0;
+    for (int32_t lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+
+// K must be a multiple of 64. vpdpbusd multiplies and accumulates straight
+// into int32, replacing the maddubs + madd + add sequence.
+inline void gemmU8S8(size_t M, size_t N, size_t K, const uint8_t* A, size_t lda, const int8_t* B, size_t ldb, int32_t* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        const uint8_t* a = A + i * lda;
+        size_t j = 0;
+        for (; j + 4 <= N; j += 4) {
+            __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t k = 0; k < K; k += 64) {
+                const __m512i x = _mm512_loadu_si512(a + k);
+                acc0 = _mm512_dpbusd_epi32(acc0, x, _mm512_loadu_si512(B + (j + 0) * ldb + k));
+                acc1 = _mm512_dpbusd_epi32(acc1, x, _mm512_loadu_si512(B + (j + 1) * ldb + k));
+                acc2 = _mm512_dpbusd_epi32(acc2, x, _mm512_loadu_si512(B + (j + 2) * ldb + k));
+                acc3 = _mm512_dpbusd_epi32(acc3, x, _mm512_loadu_si512(B + (j + 3) * ldb + k));
+            }
+            C[i * ldc + j + 0] = horizontalSum(acc0);
+            C[i * ldc + j + 1] = horizontalSum(acc1);
+            C[i * ldc + j + 2] = horizontalSum(acc2);
+            C[i * ldc + j + 3] = horizontalSum(acc3);
+        }
+        for (; j < N; ++j) {
+            __m512i acc = _mm512_setzero_si512();
+            for (size_t k = 0; k < K; k += 64) {
+                acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a + k), _mm512_loadu_si512(B + j * ldb + k));
+            }
+            C[i * ldc + j] = horizontalSum(acc);
+        }
+    }
+}
+
+} // namespace avx512
+#pragma GCC pop_options
+
+// The AVX-512 level only promises avx512f, so VNNI is checked separately.
+inline bool hasVnni() {
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni");
+    }();
+    return supported;
+}
+
+#endif // BLAS_X86
+
+// Rows of K that every kernel accepts: callers pad activations and weights
+// to a multiple of this with zeros.
+constexpr size_t INT8_K_ALIGNMENT = 64;
+
+// C = A * B^T in int32, where A is M x K uint8 activations (0..127) and B is
+// N x K int8 weights, both row-major. K must be a multiple of
+// INT8_K_ALIGNMENT.
+inline void gemmU8S8(size_t M, size_t N, size_t K, const uint8_t* A, size_t lda, const int8_t* B, size_t ldb, int32_t* C, size_t ldc) {
+#if BLAS_X86
+    switch (simdLevel()) {
+        case SimdLevel::AVX512:
+            if (hasVnni()) {
+                avx512::gemmU8S8(M, N, K, A, lda, B, ldb, C, ldc);
+                return;
+            }
+            avx2::gemmU8S8(M, N, K, A, lda, B, ldb, C, ldc);
+            return;
+        case SimdLevel::AVX2: avx2::gemmU8S8(M, N, K, A, lda, B, ldb, C, ldc); return;
+        default: break;
+    }
+#endif
+    scalar::gemmU8S8(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+inline const char* int8KernelName() {
+#if BLAS_X86
+    switch (simdLevel()) {
+        case SimdLevel::AVX512: return hasVnni() ? "avx512-vnni" : "avx2";
+        case SimdLevel::AVX2: return "avx2";
+        default: break;
+    }
+#endif
+    return "scalar";
+}
+
+} // namespace blas
+
+#endif // BLAS_INT8_H
@@ -0,0 +1,482 @@
+// SIMD kernel bodies shared by every instruction set. This file has no include
+// guard on purpose: Blas.h includes it once per ISA namespace, after switching
+// the compiler target and defining Vec<S> for that ISA. Vec<S> provides
+// loads and stores (full and partial), lane-wise arithmetic, fmadd, rounding,
+// power-of-two scaling and a horizontal sum for S = float and double.
+
+// Row-major register tile: MR rows of C, NV vectors of Vec<S>::width columns,
+// accumulated across kc steps of the shared dimension.
+template<typename S, int MR, int NV>
+inline void gemmMicroKernel(size_t kc, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc) {
+    using V = Vec<S>;
+    typename V::Reg acc[MR][NV];
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            acc[r][v] = V::load(C + r * ldc + v * V::width);
+        }
+    }
+
+    for (size_t k = 0; k < kc; ++k) {
+        typename V::Reg b[NV];
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            b[v] = V::load(B + k * ldb + v * V::width);
+        }
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            typename V::Reg a = V::set1(A[r * lda + k]);
+#pragma GCC unroll 4
+            for (int v = 0; v < NV; ++v) {
+                acc[r][v] = V::fmadd(a, b[v], acc[r][v]);
+            }
+        }
+    }
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            V::store(C + r * ldc + v * V::width, acc[r][v]);
+        }
+    }
+}
+
+// The same tile for the last n < Vec<S>::width columns, through masked loads
+// and stores, so narrow matrices (small batches at float width) stay in SIMD.
+template<typename S, int MR>
+inline void gemmMicroKernelPartial(size_t kc, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc, size_t n) {
+    using V = Vec<S>;
+    typename V::Reg acc[MR];
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r] = V::loadPartial(C + r * ldc, n);
+    }
+    for (size_t k = 0; k < kc; ++k) {
+        typename V::Reg b = V::loadPartial(B + k * ldb, n);
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            acc[r] = V::fmadd(V::set1(A[r * lda + k]), b, acc[r]);
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        V::storePartial(C + r * ldc, acc[r], n);
+    }
+}
+
+template<typename S, int MR>
+inline void gemmRowPanel(size_t nc, size_t kc, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc) {
+    using V = Vec<S>;
+    constexpr size_t NR = 2 * V::width;
+
+    size_t j = 0;
+    for (; j + NR <= nc; j += NR) {
+        gemmMicroKernel<S, MR, 2>(kc, A, lda, B + j, ldb, C + j, ldc);
+    }
+    for (; j + V::width <= nc; j += V::width) {
+        gemmMicroKernel<S, MR, 1>(kc, A, lda, B + j, ldb, C + j, ldc);
+    }
+    if (j < nc) {
+        gemmMicroKernelPartial<S, MR>(kc, A, lda, B + j, ldb, C + j, ldc, nc - j);
+    }
+}
+
+// C += A * B, blocked so that a KC x NC panel of B stays resident in L2 while
+// MR-row strips of A stream past it.
+template<typename S>
+inline void gemm(size_t M, size_t N, size_t K, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc) {
+    constexpr size_t MR = 4;
+    constexpr size_t KC = 256;
+    constexpr size_t NC = (256 * 1024) / (KC * sizeof(S));
+
+    for (size_t jc = 0; jc < N; jc += NC) {
+        const size_t nc = N - jc < NC ? N - jc : NC;
+        for (size_t pc = 0; pc < K; pc += KC) {
+            const size_t kc = K - pc < KC ? K - pc : KC;
+            const S* bPanel = B + pc * ldb + jc;
+
+            size_t i = 0;
+            for (; i + MR <= M; i += MR) {
+                gemmRowPanel<S, MR>(nc, kc, A + i * lda + pc, lda, bPanel, ldb, C + i * ldc + jc, ldc);
+            }
+            for (; i < M; ++i) {
+                gemmRowPanel<S, 1>(nc, kc, A + i * lda + pc, lda, bPanel, ldb, C + i * ldc + jc, ldc);
+            }
+        }
+    }
+}
+
+// y = A * x for a row-major A, four rows per pass so x is loaded once per four
+// dot products. When scale is non-null each result is multiplied by
+// scale[i] before it is stored.
+template<typename S>
+inline void gemv(size_t M, size_t N, const S* A, size_t lda, const S* x, S* y, const S* scale) {
+    using V = Vec<S>;
+
+    size_t i = 0;
+    for (; i + 4 <= M; i += 4) {
+        const S* a0 = A + i * lda;
+        const S* a1 = a0 + lda;
+        const S* a2 = a1 + lda;
+        const S* a3 = a2 + lda;
+        typename V::Reg acc0 = V::zero(), acc1 = V::zero(), acc2 = V::zero(), acc3 = V::zero();
+
+        size_t j = 0;
+        for (; j + V::width <= N; j += V::width) {
+            typename V::Reg xv = V::load(x + j);
+            acc0 = V::fmadd(V::load(a0 + j), xv, acc0);
+            acc1 = V::fmadd(V::load(a1 + j), xv, acc1);
+            acc2 = V::fmadd(V::load(a2 + j), xv, acc2);
+            acc3 = V::fmadd(V::load(a3 + j), xv, acc3);
+        }
+
+        S s0 = V::sum(acc0), s1 = V::sum(acc1), s2 = V::sum(acc2), s3 = V::sum(acc3);
+        for (; j < N; ++j) {
+            s0 += a0[j] * x[j];
+            s1 += a1[j] * x[j];
+            s2 += a2[j] * x[j];
+            s3 += a3[j] * x[j];
+        }
+        if (scale != nullptr) {
+            s0 *= scale[i];
+            s1 *= scale[i + 1];
+            s2 *= scale[i + 2];
+            s3 *= scale[i + 3];
+        }
+        y[i] = s0;
+        y[i + 1] = s1;
+        y[i + 2] = s2;
+        y[i + 3] = s3;
+    }
+
+    for (; i < M; ++i) {
+        const S* a = A + i * lda;
+        typename V::Reg acc = V::zero();
+        size_t j = 0;
+        for (; j + V::width <= N; j += V::width) {
+            acc = V::fmadd(V::load(a + j), V::load(x + j), acc);
+        }
+        S s = V::sum(acc);
+        for (; j < N; ++j) {
+            s += a[j] * x[j];
+        }
+        y[i] = scale != nullptr ? s * scale[i] : s;
+    }
+}
+
+// y += alpha * x
+template<typename S>
+inline void axpy(size_t n, S alpha, const S* x, S* y) {
+    using V = Vec<S>;
+    typename V::Reg a = V::set1(alpha);
+    size_t j = 0;
+    for (; j + V::width <= n; j += V::width) {
+        V::store(y + j, V::fmadd(a, V::load(x + j), V::load(y + j)));
+    }
+    if (j < n) {
+        V::storePartial(y + j, V::fmadd(a, V::loadPartial(x + j, n - j), V::loadPartial(y + j, n - j)), n - j);
+    }
+}
+
+template<typename S>
+inline S dot(size_t n, const S* x, const S* y) {
+    using V = Vec<S>;
+    typename V::Reg acc = V::zero();
+    size_t j = 0;
+    for (; j + V::width <= n; j += V::width) {
+        acc = V::fmadd(V::load(x + j), V::load(y + j), acc);
+    }
+    if (j < n) {
+        acc = V::fmadd(V::loadPartial(x + j, n - j), V::loadPartial(y + j, n - j), acc);
+    }
+    return V::sum(acc);
+}
+
+// C += A^T * B with A stored K x M. Each row of C is built from contiguous
+// rows of B, so neither operand is walked column-wise.
+template<typename S>
+inline void gemmTN(size_t M, size_t N, size_t K, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t k = 0; k < K; ++k) {
+            axpy<S>(N, A[k * lda + i], B + k * ldb, C + i * ldc);
+        }
+    }
+}
+
+// A += x * y^T for a row-major M x N A, four rows per pass so each block of y
+// is loaded once per four rows.
+template<typename S>
+inline void ger(size_t M, size_t N, const S* x, const S* y, S* A, size_t lda) {
+    using V = Vec<S>;
+
+    size_t i = 0;
+    for (; i + 4 <= M; i += 4) {
+        S* a0 = A + i * lda;
+        S* a1 = a0 + lda;
+        S* a2 = a1 + lda;
+        S* a3 = a2 + lda;
+        const typename V::Reg x0 = V::set1(x[i]), x1 = V::set1(x[i + 1]), x2 = V::set1(x[i + 2]), x3 = V::set1(x[i + 3]);
+
+        size_t j = 0;
+        for (; j + V::width <= N; j += V::width) {
+            const typename V::Reg yv = V::load(y + j);
+            V::store(a0 + j, V::fmadd(x0, yv, V::load(a0 + j)));
+            V::store(a1 + j, V::fmadd(x1, yv, V::load(a1 + j)));
+            V::store(a2 + j, V::fmadd(x2, yv, V::load(a2 + j)));
+            V::store(a3 + j, V::fmadd(x3, yv, V::load(a3 + j)));
+        }
+        if (j < N) {
+            const size_t n = N - j;
+            const typename V::Reg yv = V::loadPartial(y + j, n);
+            V::storePartial(a0 + j, V::fmadd(x0, yv, V::loadPartial(a0 + j, n)), n);
+            V::storePartial(a1 + j, V::fmadd(x1, yv, V::loadPartial(a1 + j, n)), n);
+            V::storePartial(a2 + j, V::fmadd(x2, yv, V::loadPartial(a2 + j, n)), n);
+            V::storePartial(a3 + j, V::fmadd(x3, yv, V::loadPartial(a3 + j, n)), n);
+        }
+    }
+
+    for (; i < M; ++i) {
+        axpy<S>(N, x[i], y, A + i * lda);
+    }
+}
+
+// C += A * B^T with B stored N x K: every element is a contiguous dot product.
+template<typename S>
+inline void gemmNT(size_t M, size_t N, size_t K, const S* A, size_t lda, const S* B, size_t ldb, S* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            C[i * ldc + j] += dot<S>(K, A + i * lda, B + j * ldb);
+        }
+    }
+}
+
+// Register tile of C = (A^T * B) .* D: MR rows of C (MR adjacent columns of
+// A, which is stored K x M) by NV vectors of columns. The sum starts from
+// zero and D is applied on the way out, so C is written once and never read.
+template<typename S, int MR, int NV>
+inline void gemmTNHadamardKernel(size_t K, const S* A, size_t lda, const S* B, size_t ldb, const S* D, size_t ldd, S* C, size_t ldc) {
+    using V = Vec<S>;
+    typename V::Reg acc[MR][NV];
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            acc[r][v] = V::zero();
+        }
+    }
+
+    for (size_t k = 0; k < K; ++k) {
+        typename V::Reg b[NV];
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            b[v] = V::load(B + k * ldb + v * V::width);
+        }
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            typename V::Reg a = V::set1(A[k * lda + r]);
+#pragma GCC unroll 4
+            for (int v = 0; v < NV; ++v) {
+                acc[r][v] = V::fmadd(a, b[v], acc[r][v]);
+            }
+        }
+    }
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            V::store(C + r * ldc + v * V::width, V::mul(acc[r][v], V::load(D + r * ldd + v * V::width)));
+        }
+    }
+}
+
+// The same tile for the last n < Vec<S>::width columns.
+template<typename S, int MR>
+inline void gemmTNHadamardKernelPartial(size_t K, const S* A, size_t lda, const S* B, size_t ldb, const S* D, size_t ldd, S* C, size_t ldc, size_t n) {
+    using V = Vec<S>;
+    typename V::Reg acc[MR];
+
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r] = V::zero();
+    }
+    for (size_t k = 0; k < K; ++k) {
+        typename V::Reg b = V::loadPartial(B + k * ldb, n);
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            acc[r] = V::fmadd(V::set1(A[k * lda + r]), b, acc[r]);
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        V::storePartial(C + r * ldc, V::mul(acc[r], V::loadPartial(D + r * ldd, n)), n);
+    }
+}
+
+template<typename S, int MR>
+inline void gemmTNHadamardPanel(size_t N, size_t K, const S* A, size_t lda, const S* B, size_t ldb, const S* D, size_t ldd, S* C, size_t ldc) {
+    using V = Vec<S>;
+    constexpr size_t NR = 2 * V::width;
+
+    size_t j = 0;
+    for (; j + NR <= N; j += NR) {
+        gemmTNHadamardKernel<S, MR, 2>(K, A, lda, B + j, ldb, D + j, ldd, C + j, ldc);
+    }
+    for (; j + V::width <= N; j += V::width) {
+        gemmTNHadamardKernel<S, MR, 1>(K, A, lda, B + j, ldb, D + j, ldd, C + j, ldc);
+    }
+    if (j < N) {
+        gemmTNHadamardKernelPartial<S, MR>(K, A, lda, B + j, ldb, D + j, ldd, C + j, ldc, N - j);
+    }
+}
+
+// C = (A^T * B) .* D with A stored K x M: the backpropagated deltas of a
+// whole batch in one pass, with the activation derivative fused in.
+template<typename S>
+inline void gemmTNHadamard(size_t M, size_t N, size_t K, const S* A, size_t lda, const S* B, size_t ldb, const S* D, size_t ldd, S* C, size_t ldc) {
+    constexpr size_t MR = 4;
+    size_t i = 0;
+    for (; i + MR <= M; i += MR) {
+        gemmTNHadamardPanel<S, MR>(N, K, A + i, lda, B, ldb, D + i * ldd, ldd, C + i * ldc, ldc);
+    }
+    for (; i < M; ++i) {
+        gemmTNHadamardPanel<S, 1>(N, K, A + i, lda, B, ldb, D + i * ldd, ldd, C + i * ldc, ldc);
+    }
+}
+
+// One CSR row of A against NV vectors of columns of B. The row's nonzeros
+// stream past while the output tile stays in registers, so C is written once.
+template<typename S, int NV>
+inline void spmmKernel(size_t begin, size_t end, const uint32_t* columns, const S* values, const S* B, size_t ldb, S* C) {
+    using V = Vec<S>;
+    typename V::Reg acc[NV];
+
+#pragma GCC unroll 4
+    for (int v = 0; v < NV; ++v) {
+        acc[v] = V::zero();
+    }
+    for (size_t p = begin; p < end; ++p) {
+        const typename V::Reg a = V::set1(values[p]);
+        const S* b = B + size_t(columns[p]) * ldb;
+#pragma GCC unroll 4
+        for (int v = 0; v < NV; ++v) {
+            acc[v] = V::fmadd(a, V::load(b + v * V::width), acc[v]);
+        }
+    }
+#pragma GCC unroll 4
+    for (int v = 0; v < NV; ++v) {
+        V::store(C + v * V::width, acc[v]);
+    }
+}
+
+template<typename S>
+inline void spmmKernelPartial(size_t begin, size_t end, const uint32_t* columns, const S* values, const S* B, size_t ldb, S* C, size_t n) {
+    using V = Vec<S>;
+    typename V::Reg acc = V::zero();
+    for (size_t p = begin; p < end; ++p) {
+        acc = V::fmadd(V::set1(values[p]), V::loadPartial(B + size_t(columns[p]) * ldb, n), acc);
+    }
+    V::storePartial(C, acc, n);
+}
+
+// C = A * B for an M-row CSR A and a dense row-major B. Columns of B are
+// taken in strips of four vectors, and every row of A runs over a strip
+// before the next, so the strip of B stays in L1.
+template<typename S>
+inline void spmm(size_t M, size_t N, const uint32_t* rowStart, const uint32_t* columns, const S* values, const S* B, size_t ldb, S* C, size_t ldc) {
+    using V = Vec<S>;
+    constexpr size_t NR = 4 * V::width;
+
+    size_t j = 0;
+    for (; j + NR <= N; j += NR) {
+        for (size_t i = 0; i < M; ++i) {
+            spmmKernel<S, 4>(rowStart[i], rowStart[i + 1], columns, values, B + j, ldb, C + i * ldc + j);
+        }
+    }
+    for (; j + V::width <= N; j += V::width) {
+        for (size_t i = 0; i < M; ++i) {
+            spmmKernel<S, 1>(rowStart[i], rowStart[i + 1], columns, values, B + j, ldb, C + i * ldc + j);
+        }
+    }
+    if (j < N) {
+        for (size_t i = 0; i < M; ++i) {
+            spmmKernelPartial<S>(rowStart[i], rowStart[i + 1], columns, values, B + j, ldb, C + i * ldc + j, N - j);
+        }
+    }
+}
+
+// Sum of r^(k - Lo) / k! for k in [Lo, Hi] by Estrin's scheme: the range is
+// split at a power of two and recombined with r^(2^level), so the dependency
+// chain grows with log2(degree) instead of the degree as in Horner's rule.
+template<typename S, int Lo, int Hi>
+inline typename Vec<S>::Reg taylorEstrin(const typename Vec<S>::Reg* powers) {
+    using V = Vec<S>;
+    if constexpr (Lo == Hi) {
+        return V::set1(inverseFactorial<S>(Lo));
+    } else {
+        constexpr int level = Hi - Lo >= 8 ? 3 : Hi - Lo >= 4 ? 2 : Hi - Lo >= 2 ? 1 : 0;
+        constexpr int half = 1 << level;
+        return V::fmadd(taylorEstrin<S, Lo + half, Hi>(powers), powers[level], taylorEstrin<S, Lo, Lo + half - 1>(powers));
+    }
+}
+
+// e^x as 2^n * e^r with n = round(x / ln2) and |r| <= ln2 / 2; e^r comes from
+// a Taylor polynomial of the given degree (at most 15).
+template<typename S, int Degree>
+inline typename Vec<S>::Reg expPolynomial(typename Vec<S>::Reg x) {
+    using V = Vec<S>;
+    using C = ExpConstants<S>;
+    static_assert(Degree >= 1 && Degree <= 15, "Estrin powers only go up to r^8");
+
+    x = V::min(V::max(x, V::set1(-C::clamp)), V::set1(C::clamp));
+    typename V::Reg n = V::round(V::mul(x, V::set1(C::log2e)));
+    typename V::Reg r = V::sub(x, V::mul(n, V::set1(C::ln2Hi)));
+    r = V::sub(r, V::mul(n, V::set1(C::ln2Lo)));
+
+    typename V::Reg powers[4];
+    powers[0] = r;
+    powers[1] = V::mul(r, r);
+    powers[2] = V::mul(powers[1], powers[1]);
+    powers[3] = V::mul(powers[2], powers[2]);
+
+    return V::scale2(taylorEstrin<S, 0, Degree>(powers), n);
+}
+
+template<typename S, int Degree>
+inline void sigmoidBlock(typename Vec<S>::Reg t, typename Vec<S>::Reg& s, typename Vec<S>::Reg& derivative) {
+    using V = Vec<S>;
+    typename V::Reg one = V::set1(S(1));
+    s = V::div(one, V::add(one, expPolynomial<S, Degree>(V::sub(V::zero(), t))));
+    derivative = V::mul(s, V::sub(one, s));
+}
+
+// values[j] = sigmoid(values[j] + bias) and, when derivatives is non-null,
+// derivatives[j] = s * (1 - s) from the same registers.
+template<typename S, int Degree>
+inline void sigmoid(size_t n, S* values, S bias, S* derivatives) {
+    using V = Vec<S>;
+    typename V::Reg b = V::set1(bias);
+    typename V::Reg s, derivative;
+
+    size_t j = 0;
+    for (; j + V::width <= n; j += V::width) {
+        sigmoidBlock<S, Degree>(V::add(V::load(values + j), b), s, derivative);
+        V::store(values + j, s);
+        if (derivatives != nullptr) {
+            V::store(derivatives + j, derivative);
+        }
+    }
+
+    if (j < n) {
+        sigmoidBlock<S, Degree>(V::add(V::loadPartial(values + j, n - j), b), s, derivative);
+        V::storePartial(values + j, s, n - j);
+        if (derivatives != nullptr) {
+            V::storePartial(derivatives + j, derivative, n - j);
+        }
+    }
+}
@@ -0,0 +1,264 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "Blas.h"
+#include "Matrix.h"
+#include "Inference.h"
+#include "MappedFile.h"
+#include "BinaryDataset.h"
+
+using namespace std;
+
+// On-disk model layout (native byte order):
+//   64-byte CheckpointHeader
+//   layerCount uint64 layer sizes, padded to 64 bytes
+//   CheckpointStopping, padded to 64 bytes
+//   per layer: weights (rows x cols, row-major), then biases (rows), each
+//   starting on a 64-byte boundary
+//   with CHECKPOINT_BEST_PARAMETERS, the best parameters early stopping has
+//   seen, laid out the same way
+// checksum covers every byte after the header, so a truncated or partly
+// written file is rejected instead of silently scoring garbage.
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t layerCount;
+    uint16_t sigmoidMode;
+    uint16_t flags;
+    uint64_t epochsTrained;
+    double learningRate;
+    uint64_t payloadBytes;
+    uint64_t checksum;
+    uint64_t batchSize;
+};
+
+static_assert(sizeof(CheckpointHeader) == 64, "Checkpoint header must stay 64 bytes");
+
+constexpr char CHECKPOINT_MAGIC[8] = {'M', 'L', 'P', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+// Set when early stopping ended training, so a resumed run is already done.
+constexpr uint16_t CHECKPOINT_STOPPED_EARLY = 1;
+// Set when the file holds the parameters early stopping would restore.
+constexpr uint16_t CHECKPOINT_BEST_PARAMETERS = 2;
+
+// Early-stopping progress, so a resumed run stops (and restores) exactly
+// where an uninterrupted one would.
+struct CheckpointStopping {
+    // Infinity before the first check.
+    double bestLoss = numeric_limits<double>::infinity();
+    uint64_t epochsSinceBest = 0;
+};
+
+// FNV-1a over 64-bit words in four independent lanes (so it runs at memory
+// speed), folded together with the tail bytes and the length. Every step is
+// a bijection, so changing any single word always changes the result.
+inline uint64_t checkpointChecksum(const char* data, size_t length) {
+    constexpr uint64_t basis = 14695981039346656037ull;
+    constexpr uint64_t prime = 1099511628211ull;
+    uint64_t lanes[4] = {basis, basis ^ 1, basis ^ 2, basis ^ 3};
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, data + i + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+        }
+    }
+
+    uint64_t hash = basis;
+    for (uint64_t lane : lanes) {
+        hash = (hash ^ lane) * prime;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ uint8_t(data[i])) * prime;
+    }
+    return (hash ^ uint64_t(length)) * prime;
+}
+
+// Byte offsets of every block for a given architecture; index i of weights
+// and biases is layer i (layerSizes[i] -> layerSizes[i + 1]). bestWeights
+// and bestBiases are empty without best parameters.
+template<typename T>
+struct CheckpointLayout {
+    uint64_t stopping;
+    vector<uint64_t> weights;
+    vector<uint64_t> biases;
+    vector<uint64_t> bestWeights;
+    vector<uint64_t> bestBiases;
+    uint64_t totalBytes;
+
+    CheckpointLayout(const vector<uint64_t>& layerSizes, bool bestParameters) {
+        stopping = alignDatasetOffset(sizeof(CheckpointHeader) + layerSizes.size() * sizeof(uint64_t));
+        uint64_t offset = alignDatasetOffset(stopping + sizeof(CheckpointStopping));
+        for (size_t copy = 0; copy < (bestParameters ? 2 : 1); ++copy) {
+            for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+                (copy == 0 ? weights : bestWeights).push_back(offset);
+                offset = alignDatasetOffset(offset + layerSizes[i + 1] * layerSizes[i] * sizeof(T));
+                (copy == 0 ? biases : bestBiases).push_back(offset);
+                offset = alignDatasetOffset(offset + layerSizes[i + 1] * sizeof(T));
+            }
+        }
+        totalBytes = offset;
+    }
+};
+
+// Writes a checkpoint to path + ".tmp" and renames it into place, so readers
+// only ever see complete files. weights[i] and biases[i] point at layer i's
+// row-major parameters, and bestWeights/bestBiases (empty for none) at the
+// best ones early stopping has kept.
+template<typename T>
+void writeCheckpoint(const string& path, const vector<uint64_t>& layerSizes, const vector<const T*>& weights, const vector<const T*>& biases, double learningRate, uint64_t batchSize, blas::SigmoidMode mode, uint64_t epochsTrained, uint16_t flags = 0,
+                     const CheckpointStopping& stopping = {}, const vector<const T*>& bestWeights = {}, const vector<const T*>& bestBiases = {}) {
+    const bool bestParameters = !bestWeights.empty();
+    const CheckpointLayout<T> layout(layerSizes, bestParameters);
+    vector<char> image(layout.totalBytes, 0);
+
+    memcpy(image.data() + sizeof(CheckpointHeader), layerSizes.data(), layerSizes.size() * sizeof(uint64_t));
+    memcpy(image.data() + layout.stopping, &stopping, sizeof(stopping));
+    for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+        memcpy(image.data() + layout.weights[i], weights[i], layerSizes[i + 1] * layerSizes[i] * sizeof(T));
+        memcpy(image.data() + layout.biases[i], biases[i], layerSizes[i + 1] * sizeof(T));
+        if (bestParameters) {
+            memcpy(image.data() + layout.bestWeights[i], bestWeights[i], layerSizes[i + 1] * layerSizes[i] * sizeof(T));
+            memcpy(image.data() + layout.bestBiases[i], bestBiases[i], layerSizes[i + 1] * sizeof(T));
+        }
+    }
+
+    CheckpointHeader header{};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.dtype = uint32_t(datasetTypeOf<T>());
+    header.layerCount = uint32_t(layerSizes.size());
+    header.sigmoidMode = uint16_t(mode);
+    header.flags = uint16_t(bestParameters ? flags | CHECKPOINT_BEST_PARAMETERS : flags & ~CHECKPOINT_BEST_PARAMETERS);
+    header.epochsTrained = epochsTrained;
+    header.learningRate = learningRate;
+    header.batchSize = batchSize;
+    header.payloadBytes = layout.totalBytes - sizeof(CheckpointHeader);
+    header.checksum = checkpointChecksum(image.data() + sizeof(CheckpointHeader), header.payloadBytes);
+    memcpy(image.data(), &header, sizeof(header));
+
+    const string temporary = path + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            throw runtime_error("Cannot open file " + temporary);
+        }
+        file.write(image.data(), streamsize(image.size()));
+        if (!file) {
+            throw runtime_error("Failed writing " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        throw runtime_error("Cannot replace " + path);
+    }
+}
+
+// A checkpoint mapped read-only. Parameters are read in place, so loading
+// costs one pass for the checksum (skippable) and inference runs straight
+// off the mapping.
+template<typename T>
+class MappedModel {
+private:
+    MappedFile file;
+    CheckpointHeader header;
+    vector<size_t> layerSizes;
+    vector<const T*> weightBlocks;
+    vector<const T*> biasBlocks;
+    vector<const T*> bestWeightBlocks;
+    vector<const T*> bestBiasBlocks;
+    CheckpointStopping stoppingState;
+    size_t maxLayerWidth = 0;
+
+    inference::Layer<T> layer(size_t i) const {
+        return {weightBlocks[i], biasBlocks[i], layerSizes[i + 1], layerSizes[i]};
+    }
+
+public:
+    explicit MappedModel(const string& path, bool verifyChecksum = true) : file(path) {
+        if (file.size() < sizeof(CheckpointHeader)) {
+            throw runtime_error("Truncated checkpoint " + path);
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+            throw runtime_error("Not a checkpoint file: " + path);
+        }
+        if (header.version != CHECKPOINT_VERSION) {
+            throw runtime_error("Unsupported checkpoint version in " + path);
+        }
+        if (header.dtype != uint32_t(datasetTypeOf<T>())) {
+            throw runtime_error("Checkpoint element type does not match in " + path);
+        }
+        if (header.layerCount < 2 || sizeof(CheckpointHeader) + header.layerCount * sizeof(uint64_t) > file.size() ||
+            header.payloadBytes != file.size() - sizeof(CheckpointHeader)) {
+            throw runtime_error("Corrupt checkpoint layout in " + path);
+        }
+
+        vector<uint64_t> sizes(header.layerCount);
+        memcpy(sizes.data(), file.data() + sizeof(CheckpointHeader), sizes.size() * sizeof(uint64_t));
+        const CheckpointLayout<T> layout(sizes, (header.flags & CHECKPOINT_BEST_PARAMETERS) != 0);
+        if (layout.totalBytes != file.size()) {
+            throw runtime_error("Corrupt checkpoint layout in " + path);
+        }
+        if (verifyChecksum && checkpointChecksum(file.data() + sizeof(CheckpointHeader), header.payloadBytes) != header.checksum) {
+            throw runtime_error("Checkpoint checksum mismatch in " + path);
+        }
+
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            layerSizes.push_back(size_t(sizes[i]));
+            maxLayerWidth = max(maxLayerWidth, layerSizes.back());
+        }
+        for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+            weightBlocks.push_back(reinterpret_cast<const T*>(file.data() + layout.weights[i]));
+            biasBlocks.push_back(reinterpret_cast<const T*>(file.data() + layout.biases[i]));
+        }
+        for (size_t i = 0; i < layout.bestWeights.size(); ++i) {
+            bestWeightBlocks.push_back(reinterpret_cast<const T*>(file.data() + layout.bestWeights[i]));
+            bestBiasBlocks.push_back(reinterpret_cast<const T*>(file.data() + layout.bestBiases[i]));
+        }
+        memcpy(&stoppingState, file.data() + layout.stopping, sizeof(stoppingState));
+    }
+
+    const vector<size_t>& getLayerSizes() const { return layerSizes; }
+    size_t inputSize() const { return layerSizes.front(); }
+    size_t outputSize() const { return layerSizes.back(); }
+    T getLearningRate() const { return T(header.learningRate); }
+    size_t getBatchSize() const { return size_t(header.batchSize); }
+    blas::SigmoidMode sigmoidMode() const { return blas::SigmoidMode(header.sigmoidMode); }
+    uint64_t getEpochsTrained() const { return header.epochsTrained; }
+    bool stoppedEarly() const { return (header.flags & CHECKPOINT_STOPPED_EARLY) != 0; }
+    const CheckpointStopping& stopping() const { return stoppingState; }
+
+    // Layer i's weights (layerSizes[i + 1] x layerSizes[i]) and biases.
+    const T* weights(size_t layer) const { return weightBlocks.at(layer); }
+    const T* biases(size_t layer) const { return biasBlocks.at(layer); }
+
+    // The best parameters early stopping has kept, when the file has them.
+    bool hasBestParameters() const { return !bestWeightBlocks.empty(); }
+    const T* bestWeights(size_t layer) const { return bestWeightBlocks.at(layer); }
+    const T* bestBiases(size_t layer) const { return bestBiasBlocks.at(layer); }
+
+    // Same contract as MLP::predict / MLP::predictBatch, through the same
+    // forward pass.
+    void predict(const T* input, T* output) const {
+        inference::predict(weightBlocks.size(), maxLayerWidth, sigmoidMode(), [this](size_t i) { return layer(i); }, input, output);
+    }
+
+    void predictBatch(const T* inputs, size_t count, T* outputs) const {
+        inference::predictBatch(weightBlocks.size(), maxLayerWidth, sigmoidMode(), [this](size_t i) { return layer(i); }, inputs, count, outputs);
+    }
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,27 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// A nonnegative integer option value no larger than maxValue; anything else
+// throws invalid_argument naming the option.
+inline uint64_t parseCount(const char* option, const char* text, uint64_t maxValue = UINT64_MAX) {
+    size_t end = 0;
+    unsigned long long value = 0;
+    try {
+        value = stoull(text, &end);
+    } catch (const exception&) {
+        end = 0;
+    }
+    if (end == 0 || text[end] != '\0' || strchr(text, '-') != nullptr || value > maxValue) {
+        throw invalid_argument(string("Invalid value for ") + option + ": " + text);
+    }
+    return uint64_t(value);
+}
+
+#endif // COMMAND_LINE_H
@@ -0,0 +1,209 @@
+#ifndef CSV_LOADER_H
+#define CSV_LOADER_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Which header columns feed the network and which are its targets, in the
+// order they should appear in each row of the loaded buffers.
+struct CsvColumns {
+    vector<string> inputs;
+    vector<string> outputs;
+};
+
+// Row-major samples: features is rows x inputDim and labels rows x outputDim,
+// each one contiguous aligned buffer.
+template<typename T>
+struct CsvTable {
+    vector<T, AlignedAllocator<T>> features;
+    vector<T, AlignedAllocator<T>> labels;
+    size_t rows = 0;
+    size_t inputDim = 0;
+    size_t outputDim = 0;
+};
+
+namespace csv {
+
+// Files smaller than this per thread are not worth splitting.
+constexpr size_t minChunkBytes = 1 << 20;
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* lineEnd(const char* p, const char* end) {
+    const void* newline = memchr(p, '\n', size_t(end - p));
+    return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+inline bool isEmptyLine(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p == end;
+}
+
+inline vector<string> splitHeader(const char* p, const char* end) {
+    vector<string> names;
+    while (true) {
+        const char* comma = find(p, end, ',');
+        const char* first = p;
+        const char* last = comma;
+        while (first < last && isBlank(*first)) ++first;
+        while (last > first && isBlank(last[-1])) --last;
+        names.emplace_back(first, last);
+        if (comma == end) {
+            break;
+        }
+        p = comma + 1;
+    }
+    return names;
+}
+
+inline size_t countRows(const char* p, const char* end) {
+    size_t rows = 0;
+    while (p < end) {
+        const char* stop = lineEnd(p, end);
+        if (!isEmptyLine(p, stop)) {
+            ++rows;
+        }
+        p = stop + 1;
+    }
+    return rows;
+}
+
+// Parses one non-empty line [p, stop) into a feature and a label row. row
+// only numbers the error messages. target[c] is the feature slot of column
+// c, -2 - slot for a label, or -1 to skip the column.
+template<typename T>
+void parseLine(const char* p, const char* stop, const vector<long>& target, size_t neededColumns, T* features, T* labels, size_t row) {
+    size_t column = 0;
+    for (const char* field = p; column < neededColumns; ++column) {
+        if (field > stop) {
+            throw runtime_error("Row " + to_string(row + 1) + " has too few columns");
+        }
+        const char* comma = find(field, stop, ',');
+        if (target[column] != -1) {
+            const char* first = field;
+            while (first < comma && (isBlank(*first) || *first == '+')) ++first;
+            double value = 0.0;
+            from_chars_result parsed = from_chars(first, comma, value);
+            const char* rest = parsed.ptr;
+            while (rest < comma && isBlank(*rest)) ++rest;
+            if (parsed.ec != errc() || rest != comma) {
+                throw runtime_error("Row " + to_string(row + 1) + ", column " + to_string(column + 1) + ": invalid number");
+            }
+            if (target[column] >= 0) {
+                features[target[column]] = T(value);
+            } else {
+                labels[-2 - target[column]] = T(value);
+            }
+        }
+        field = comma + 1;
+    }
+}
+
+// Parses the non-empty lines of [p, end) into rows starting at firstRow.
+template<typename T>
+void parseRows(const char* p, const char* end, const vector<long>& target, size_t neededColumns, CsvTable<T>& table, size_t firstRow) {
+    size_t row = firstRow;
+    while (p < end) {
+        const char* stop = lineEnd(p, end);
+        if (!isEmptyLine(p, stop)) {
+            parseLine(p, stop, target, neededColumns, table.features.data() + row * table.inputDim, table.labels.data() + row * table.outputDim, row);
+            ++row;
+        }
+        p = stop + 1;
+    }
+}
+
+// Maps the header line [p, end) onto columns: fills target (see parseLine)
+// and returns how many leading columns a row must have.
+inline size_t bindColumns(const char* p, const char* end, const CsvColumns& columns, const string& path, vector<long>& target) {
+    const vector<string> header = splitHeader(p, end);
+    target.assign(header.size(), -1);
+    size_t neededColumns = 0;
+    auto bind = [&](const string& name, long slot) {
+        auto found = find(header.begin(), header.end(), name);
+        if (found == header.end()) {
+            throw runtime_error("Column '" + name + "' not found in " + path);
+        }
+        const size_t column = size_t(found - header.begin());
+        target[column] = slot;
+        neededColumns = max(neededColumns, column + 1);
+    };
+    for (size_t i = 0; i < columns.inputs.size(); ++i) {
+        bind(columns.inputs[i], long(i));
+    }
+    for (size_t i = 0; i < columns.outputs.size(); ++i) {
+        bind(columns.outputs[i], -2 - long(i));
+    }
+    return neededColumns;
+}
+
+} // namespace csv
+
+// Loads a headered numeric CSV into contiguous feature and label buffers.
+// Large files are cut into chunks at line boundaries and each chunk is
+// counted and then parsed on its own thread; threads = 0 uses every core.
+template<typename T>
+CsvTable<T> loadCsv(const string& path, const CsvColumns& columns, size_t threads = 0) {
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if (file.size() == 0) {
+        throw runtime_error("Empty CSV file " + path);
+    }
+
+    const char* headerEnd = csv::lineEnd(begin, end);
+    const char* body = headerEnd < end ? headerEnd + 1 : end;
+
+    CsvTable<T> table;
+    table.inputDim = columns.inputs.size();
+    table.outputDim = columns.outputs.size();
+
+    vector<long> target;
+    const size_t neededColumns = csv::bindColumns(begin, headerEnd, columns, path, target);
+
+    if (threads == 0) {
+        threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+    const size_t bodyBytes = size_t(end - body);
+    const size_t chunkCount = max<size_t>(1, min(threads, bodyBytes / csv::minChunkBytes));
+
+    vector<const char*> bounds(chunkCount + 1, end);
+    bounds[0] = body;
+    for (size_t c = 1; c < chunkCount; ++c) {
+        const char* guess = max(bounds[c - 1], body + c * bodyBytes / chunkCount);
+        bounds[c] = guess < end ? min(end, csv::lineEnd(guess, end) + 1) : end;
+    }
+
+    ThreadPool pool(chunkCount);
+    vector<size_t> firstRow(chunkCount + 1, 0);
+    pool.parallelFor(chunkCount, [&](size_t c) {
+        firstRow[c + 1] = csv::countRows(bounds[c], bounds[c + 1]);
+    });
+    for (size_t c = 0; c < chunkCount; ++c) {
+        firstRow[c + 1] += firstRow[c];
+    }
+
+    table.rows = firstRow[chunkCount];
+    table.features.resize(table.rows * table.inputDim);
+    table.labels.resize(table.rows * table.outputDim);
+
+    pool.parallelFor(chunkCount, [&](size_t c) {
+        csv::parseRows(bounds[c], bounds[c + 1], target, neededColumns, table, firstRow[c]);
+    });
+
+    return table;
+}
+
+#endif // CSV_LOADER_H
@@ -0,0 +1,518 @@
+#ifndef DATA_STREAM_H
+#define DATA_STREAM_H
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
+
+#include "Matrix.h"
+#include "CsvLoader.h"
+#include "BinaryDataset.h"
+
+using namespace std;
+
+// Samples read front to back, one pass per epoch, without holding the whole
+// set in memory. Only DataStream's producer thread calls rewind and read.
+template<typename T>
+class DataSource {
+public:
+    virtual ~DataSource() = default;
+
+    virtual size_t inputDim() const = 0;
+    virtual size_t outputDim() const = 0;
+
+    // Goes back to the first sample.
+    virtual void rewind() = 0;
+
+    // Reads up to maxRows samples into row-major features (maxRows x
+    // inputDim) and labels (maxRows x outputDim). Returns how many were
+    // read; 0 means the pass is over.
+    virtual size_t read(size_t maxRows, T* features, T* labels) = 0;
+};
+
+// Samples already in memory, one per row of each view. The views must
+// outlive the source.
+template<typename T>
+class ViewSource : public DataSource<T> {
+private:
+    MatrixView<const T> features;
+    MatrixView<const T> labels;
+    size_t next = 0;
+
+    static void copyRows(const MatrixView<const T>& view, size_t first, size_t count, T* out) {
+        for (size_t r = 0; r < count; ++r) {
+            for (size_t c = 0; c < view.getCols(); ++c) {
+                out[r * view.getCols() + c] = view(first + r, c);
+            }
+        }
+    }
+
+public:
+    ViewSource(MatrixView<const T> inputs, MatrixView<const T> targets) : features(inputs), labels(targets) {
+        if (inputs.getRows() != targets.getRows()) {
+            throw invalid_argument("Feature and label views have different row counts");
+        }
+    }
+
+    size_t inputDim() const override { return features.getCols(); }
+    size_t outputDim() const override { return labels.getCols(); }
+
+    void rewind() override { next = 0; }
+
+    size_t read(size_t maxRows, T* featureRows, T* labelRows) override {
+        const size_t count = min(maxRows, features.getRows() - next);
+        copyRows(features, next, count, featureRows);
+        copyRows(labels, next, count, labelRows);
+        next += count;
+        return count;
+    }
+};
+
+// A mapped binary dataset file. Pages are faulted in by the thread that
+// reads them, so with a DataStream the disk reads overlap training.
+template<typename T>
+class BinaryFileSource : public DataSource<T> {
+private:
+    BinaryDataset<T> dataset;
+    ViewSource<T> rows;
+
+public:
+    explicit BinaryFileSource(const string& path) : dataset(path), rows(dataset.features(), dataset.labels()) {}
+
+    size_t inputDim() const override { return dataset.inputDim(); }
+    size_t outputDim() const override { return dataset.outputDim(); }
+    size_t rowCount() const { return dataset.rows(); }
+
+    void rewind() override { rows.rewind(); }
+    size_t read(size_t maxRows, T* features, T* labels) override { return rows.read(maxRows, features, labels); }
+};
+
+// A headered numeric CSV read in fixed-size chunks and parsed as it goes,
+// so memory stays at one chunk however large the file is.
+template<typename T>
+class CsvFileSource : public DataSource<T> {
+private:
+    static constexpr size_t chunkBytes = 1 << 20;
+
+    string path;
+    size_t featureCount;
+    size_t labelCount;
+    ifstream file;
+    streampos bodyStart;
+    vector<long> target;
+    size_t neededColumns = 0;
+
+    // Unparsed bytes are buffer[begin, end); a line longer than the buffer
+    // grows it.
+    vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool atEof = false;
+    size_t row = 0;
+
+    // Moves the unparsed tail to the front and reads more after it.
+    void refill() {
+        memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        if (end == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        file.read(buffer.data() + end, streamsize(buffer.size() - end));
+        end += size_t(file.gcount());
+        if (file.eof()) {
+            atEof = true;
+        } else if (!file) {
+            throw runtime_error("Failed reading " + path);
+        }
+    }
+
+public:
+    CsvFileSource(const string& csvPath, const CsvColumns& columns) : path(csvPath), featureCount(columns.inputs.size()), labelCount(columns.outputs.size()), file(csvPath, ios::binary), buffer(chunkBytes) {
+        if (!file.is_open()) {
+            throw runtime_error("Cannot open file " + path);
+        }
+        string header;
+        if (!getline(file, header)) {
+            throw runtime_error("Empty CSV file " + path);
+        }
+        neededColumns = csv::bindColumns(header.data(), header.data() + header.size(), columns, path, target);
+        bodyStart = file.tellg();
+        rewind();
+    }
+
+    size_t inputDim() const override { return featureCount; }
+    size_t outputDim() const override { return labelCount; }
+
+    void rewind() override {
+        file.clear();
+        file.seekg(bodyStart);
+        begin = end = 0;
+        atEof = bodyStart == streampos(-1);
+        row = 0;
+    }
+
+    size_t read(size_t maxRows, T* featureRows, T* labelRows) override {
+        size_t count = 0;
+        while (count < maxRows) {
+            const char* p = buffer.data() + begin;
+            const char* limit = buffer.data() + end;
+            const char* stop = csv::lineEnd(p, limit);
+            if (stop == limit && !atEof) {
+                refill();
+                continue;
+            }
+            if (p == limit) {
+                break;
+            }
+            if (!csv::isEmptyLine(p, stop)) {
+                csv::parseLine(p, stop, target, neededColumns, featureRows + count * featureCount, labelRows + count * labelCount, row);
+                ++count;
+                ++row;
+            }
+            begin = min(end, size_t(stop - buffer.data()) + 1);
+        }
+        return count;
+    }
+};
+
+struct StreamConfig {
+    // Samples per batch. In mini-batch training each batch is one optimizer
+    // step; in full-batch training the epoch's batches are summed first.
+    size_t batchRows = 256;
+    // Samples held for shuffling. Each batch row is drawn at random from the
+    // window, which is then refilled from the source, so memory stays at
+    // the window however large the file is. 0 or 1 keeps file order.
+    size_t shuffleWindow = 0;
+    // Filled batches the producer may keep ahead of the consumer; 2 is
+    // double buffering.
+    size_t queueDepth = 2;
+    // The shuffle of pass p is seeded from seed + p, so a pass is the same
+    // on every run.
+    uint64_t seed = 0;
+};
+
+// One packed batch: the first rows rows of inputs and targets are valid.
+template<typename T>
+struct StreamBatch {
+    Matrix<T> inputs;
+    Matrix<T> targets;
+    size_t rows = 0;
+
+    MatrixView<const T> inputView() const { return MatrixView<const T>(inputs.getData(), rows, inputs.getCols(), inputs.getCols()); }
+    MatrixView<const T> targetView() const { return MatrixView<const T>(targets.getData(), rows, targets.getCols(), targets.getCols()); }
+};
+
+// Reads, parses, shuffles and packs batches from a DataSource on a
+// background thread while the caller trains on the previous one. Batches
+// come from a fixed pool of queueDepth + 1 buffers, one of them held by
+// the consumer, so the producer blocks rather than running ahead. After a
+// pass ends the producer starts prefetching the next one, so I/O also
+// overlaps the work between epochs.
+//
+//     stream.beginEpoch(epoch);
+//     while (const StreamBatch<T>* batch = stream.next()) { ... }
+//
+// A batch stays valid until the next call to next or beginEpoch. The
+// source must outlive the stream.
+template<typename T>
+class DataStream {
+private:
+    static constexpr size_t endOfPass = size_t(-1);
+
+    struct Ready {
+        size_t slot;
+        uint64_t pass;
+    };
+
+    DataSource<T>& source;
+    StreamConfig config;
+
+    mutex lock;
+    condition_variable wakeProducer;
+    condition_variable slotFree;
+    condition_variable batchReady;
+
+    vector<StreamBatch<T>> slots;
+    vector<size_t> freeSlots;
+    deque<Ready> ready;
+    size_t held = endOfPass;
+
+    bool running = false;
+    bool restart = false;
+    bool stopping = false;
+    uint64_t producerPass = 0;
+    uint64_t consumerPass = 0;
+    bool atPassStart = false;
+    exception_ptr failure;
+    double stalled = 0.0;
+
+    // Producer-only: the shuffle window and a staging block it is refilled
+    // from, so the source is read in batch-sized calls.
+    Matrix<T> windowInputs;
+    Matrix<T> windowTargets;
+    Matrix<T> stageInputs;
+    Matrix<T> stageTargets;
+    size_t stagePos = 0;
+    size_t stageCount = 0;
+    bool sourceDone = false;
+
+    thread producer;
+
+    static void copyRow(const Matrix<T>& from, size_t fromRow, Matrix<T>& to, size_t toRow) {
+        const size_t width = from.getCols();
+        copy(from.getData() + fromRow * width, from.getData() + (fromRow + 1) * width, to.getData() + toRow * width);
+    }
+
+    // Next source sample into window row; false at the end of the source.
+    bool takeRow(size_t row) {
+        if (stagePos == stageCount) {
+            stagePos = 0;
+            stageCount = sourceDone ? 0 : source.read(config.batchRows, stageInputs.getData(), stageTargets.getData());
+            sourceDone = stageCount == 0;
+            if (sourceDone) {
+                return false;
+            }
+        }
+        copyRow(stageInputs, stagePos, windowInputs, row);
+        copyRow(stageTargets, stagePos, windowTargets, row);
+        ++stagePos;
+        return true;
+    }
+
+    // A free buffer, or endOfPass when the pass is being abandoned.
+    size_t acquireSlot() {
+        unique_lock<mutex> guard(lock);
+        slotFree.wait(guard, [&] { return stopping || restart || !freeSlots.empty(); });
+        if (stopping || restart) {
+            return endOfPass;
+        }
+        const size_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    // Queues a filled buffer or the end-of-pass marker; false (with the
+    // buffer returned to the pool) when the pass is being abandoned.
+    bool publish(size_t slot, uint64_t pass) {
+        lock_guard<mutex> guard(lock);
+        if (stopping || restart) {
+            if (slot != endOfPass) {
+                freeSlots.push_back(slot);
+            }
+            return false;
+        }
+        ready.push_back({slot, pass});
+        batchReady.notify_one();
+        return true;
+    }
+
+    // Produces one whole pass; false if it was cut short.
+    bool producePass(uint64_t pass) {
+        source.rewind();
+        stagePos = stageCount = 0;
+        sourceDone = false;
+
+        const bool shuffled = config.shuffleWindow > 1;
+        size_t windowRows = 0;
+        while (shuffled && windowRows < config.shuffleWindow && takeRow(windowRows)) {
+            ++windowRows;
+        }
+        mt19937_64 rng(config.seed + pass);
+
+        bool exhausted = false;
+        while (!exhausted) {
+            const size_t slot = acquireSlot();
+            if (slot == endOfPass) {
+                return false;
+            }
+            StreamBatch<T>& batch = slots[slot];
+            size_t rows = 0;
+            if (shuffled) {
+                for (; rows < config.batchRows && windowRows > 0; ++rows) {
+                    const size_t pick = size_t(rng() % windowRows);
+                    copyRow(windowInputs, pick, batch.inputs, rows);
+                    copyRow(windowTargets, pick, batch.targets, rows);
+                    if (!takeRow(pick)) {
+                        --windowRows;
+                        copyRow(windowInputs, windowRows, windowInputs, pick);
+                        copyRow(windowTargets, windowRows, windowTargets, pick);
+                    }
+                }
+                exhausted = windowRows == 0;
+            } else {
+                while (rows < config.batchRows) {
+                    const size_t count = source.read(config.batchRows - rows, batch.inputs.getData() + rows * batch.inputs.getCols(), batch.targets.getData() + rows * batch.targets.getCols());
+                    if (count == 0) {
+                        exhausted = true;
+                        break;
+                    }
+                    rows += count;
+                }
+            }
+
+            batch.rows = rows;
+            if (rows == 0) {
+                lock_guard<mutex> guard(lock);
+                freeSlots.push_back(slot);
+            } else if (!publish(slot, pass)) {
+                return false;
+            }
+        }
+        return publish(endOfPass, pass);
+    }
+
+    void producerLoop() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wakeProducer.wait(guard, [&] { return stopping || running; });
+            if (stopping) {
+                return;
+            }
+            const uint64_t pass = producerPass;
+            restart = false;
+            guard.unlock();
+
+            bool finished = false;
+            exception_ptr error;
+            try {
+                finished = producePass(pass);
+            } catch (...) {
+                error = current_exception();
+            }
+
+            guard.lock();
+            if (error) {
+                failure = error;
+                running = false;
+                batchReady.notify_all();
+            } else if (finished && !restart) {
+                producerPass = pass + 1;
+            }
+        }
+    }
+
+    void releaseHeld() {
+        if (held != endOfPass) {
+            freeSlots.push_back(held);
+            held = endOfPass;
+            slotFree.notify_one();
+        }
+    }
+
+public:
+    DataStream(DataSource<T>& dataSource, const StreamConfig& streamConfig) : source(dataSource), config(streamConfig) {
+        if (config.batchRows == 0 || config.queueDepth == 0) {
+            throw invalid_argument("Stream batches and queue depth must be nonzero");
+        }
+        const size_t in = source.inputDim();
+        const size_t out = source.outputDim();
+        for (size_t s = 0; s <= config.queueDepth; ++s) {
+            slots.push_back({Matrix<T>(config.batchRows, in), Matrix<T>(config.batchRows, out), 0});
+            freeSlots.push_back(s);
+        }
+        if (config.shuffleWindow > 1) {
+            windowInputs = Matrix<T>(config.shuffleWindow, in);
+            windowTargets = Matrix<T>(config.shuffleWindow, out);
+            stageInputs = Matrix<T>(config.batchRows, in);
+            stageTargets = Matrix<T>(config.batchRows, out);
+        }
+        producer = thread([this] { producerLoop(); });
+    }
+
+    ~DataStream() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wakeProducer.notify_one();
+        slotFree.notify_one();
+        producer.join();
+    }
+
+    DataStream(const DataStream&) = delete;
+    DataStream& operator=(const DataStream&) = delete;
+
+    size_t inputDim() const { return source.inputDim(); }
+    size_t outputDim() const { return source.outputDim(); }
+    const StreamConfig& getConfig() const { return config; }
+
+    // Positions the stream at the start of pass. When the producer is
+    // already prefetching that pass the batches it has queued are kept;
+    // otherwise they are dropped and it restarts there.
+    void beginEpoch(uint64_t pass) {
+        lock_guard<mutex> guard(lock);
+        releaseHeld();
+        if (running && atPassStart && consumerPass == pass) {
+            return;
+        }
+        for (const Ready& entry : ready) {
+            if (entry.slot != endOfPass) {
+                freeSlots.push_back(entry.slot);
+            }
+        }
+        ready.clear();
+        failure = nullptr;
+        producerPass = pass;
+        consumerPass = pass;
+        atPassStart = true;
+        restart = true;
+        running = true;
+        wakeProducer.notify_one();
+        slotFree.notify_one();
+    }
+
+    // The next batch of the current pass, or nullptr once it is over.
+    // Rethrows anything the source threw.
+    const StreamBatch<T>* next() {
+        unique_lock<mutex> guard(lock);
+        releaseHeld();
+        while (true) {
+            const auto start = chrono::steady_clock::now();
+            batchReady.wait(guard, [&] { return !ready.empty() || failure || !running; });
+            stalled += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (failure) {
+                rethrow_exception(failure);
+            }
+            if (ready.empty()) {
+                throw logic_error("DataStream::next called before beginEpoch");
+            }
+
+            const Ready entry = ready.front();
+            ready.pop_front();
+            if (entry.pass != consumerPass) {
+                if (entry.slot != endOfPass) {
+                    freeSlots.push_back(entry.slot);
+                    slotFree.notify_one();
+                }
+                continue;
+            }
+            if (entry.slot == endOfPass) {
+                ++consumerPass;
+                atPassStart = true;
+                return nullptr;
+            }
+            atPassStart = false;
+            held = entry.slot;
+            return &slots[held];
+        }
+    }
+
+    // Seconds next has spent waiting for the producer: near zero when
+    // loading keeps up with training.
+    double stallSeconds() {
+        lock_guard<mutex> guard(lock);
+        return stalled;
+    }
+};
+
+#endif // DATA_STREAM_H
@@ -0,0 +1,104 @@
+#ifndef INFERENCE_H
+#define INFERENCE_H
+
+#include <vector>
+#include <algorithm>
+
+#include "Blas.h"
+#include "Matrix.h"
+#include "SparseMatrix.h"
+
+using namespace std;
+
+// The row-major forward pass shared by MLP and MappedModel, so a trained
+// model and its mapped checkpoint score samples through the same code. The
+// functions take layer(i), which returns a Layer for layer i.
+namespace inference {
+
+template<typename T>
+struct Layer {
+    // rows x cols, row-major.
+    const T* weights;
+    const T* biases;
+    size_t rows;
+    size_t cols;
+    // A CSR copy that predict uses in place of the dense weights.
+    const CsrMatrix<T>* sparse = nullptr;
+};
+
+// out[r][j] = sigmoid(out[r][j] + bias[j]) over rows contiguous samples of
+// one layer's output; the sigmoid runs once over the whole block.
+template<typename T>
+void addBiasAndActivate(T* out, const T* bias, size_t rows, size_t width, blas::SigmoidMode mode) {
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t j = 0; j < width; ++j) {
+            out[r * width + j] += bias[j];
+        }
+    }
+    blas::sigmoid(rows * width, out, T{}, static_cast<T*>(nullptr), mode);
+}
+
+// Per-thread ping-pong storage for the inference entry points. It only
+// grows, so after a thread's first call scoring never allocates, and
+// concurrent callers on a shared const model never see each other's data.
+template<typename T>
+T* scratch(size_t count) {
+    static thread_local vector<T, AlignedAllocator<T>> buffer;
+    if (buffer.size() < count) {
+        buffer.resize(count);
+    }
+    return buffer.data();
+}
+
+// Scores one sample through layers layers, maxWidth the widest. Layers
+// alternate between two scratch rows and the last one writes straight into
+// output.
+template<typename T, typename LayerAt>
+void predict(size_t layers, size_t maxWidth, blas::SigmoidMode mode, LayerAt layer, const T* input, T* output) {
+    T* rows = scratch<T>(2 * maxWidth);
+    const T* current = input;
+
+    for (size_t i = 0; i < layers; ++i) {
+        const Layer<T> l = layer(i);
+        T* next = i + 1 == layers ? output : rows + (i % 2) * maxWidth;
+
+        if (l.sparse != nullptr) {
+            l.sparse->multiplyVector(current, next);
+        } else {
+            blas::gemv(l.rows, l.cols, l.weights, l.cols, current, next);
+        }
+        addBiasAndActivate(next, l.biases, 1, l.rows, mode);
+        current = next;
+    }
+}
+
+// Scores count row-major samples into a row-major output, one GEMM per layer
+// per block of rows. Dense layers only: sparse is ignored.
+template<typename T, typename LayerAt>
+void predictBatch(size_t layers, size_t maxWidth, blas::SigmoidMode mode, LayerAt layer, const T* inputs, size_t count, T* outputs) {
+    constexpr size_t blockRows = 64;
+    if (layers == 0) {
+        return;
+    }
+    T* block = scratch<T>(2 * blockRows * maxWidth);
+    const size_t inputWidth = layer(0).cols;
+    const size_t outputWidth = layer(layers - 1).rows;
+
+    for (size_t first = 0; first < count; first += blockRows) {
+        const size_t rows = min(blockRows, count - first);
+        const T* current = inputs + first * inputWidth;
+
+        for (size_t i = 0; i < layers; ++i) {
+            const Layer<T> l = layer(i);
+            T* next = i + 1 == layers ? outputs + first * outputWidth : block + (i % 2) * blockRows * maxWidth;
+
+            blas::gemmNT(rows, l.rows, l.cols, current, l.cols, l.weights, l.cols, next, l.rows);
+            addBiasAndActivate(next, l.biases, rows, l.rows, mode);
+            current = next;
+        }
+    }
+}
+
+} // namespace inference
+
+#endif // INFERENCE_H
@@ -0,0 +1,299 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <condition_variable>
+
+#include <unistd.h>
+
+#include "Matrix.h"
+
+using namespace std;
+
+struct ServerOptions {
+    size_t maxBatch = 64;
+    chrono::microseconds maxWait{500};
+    size_t maxQueue = 4096;
+};
+
+// Where one client's responses go. Only the batching thread writes to it,
+// so responses reach each client in the order its requests arrived.
+class ResponseSink {
+private:
+    int fd;
+    bool ownsFd;
+    string pending;
+
+public:
+    ResponseSink(int descriptor, bool owns) : fd(descriptor), ownsFd(owns) {}
+
+    ~ResponseSink() {
+        if (ownsFd) {
+            close(fd);
+        }
+    }
+
+    ResponseSink(const ResponseSink&) = delete;
+    ResponseSink& operator=(const ResponseSink&) = delete;
+
+    int descriptor() const { return fd; }
+
+    void append(const string& text) { pending += text; }
+    void append(const char* text, size_t length) { pending.append(text, length); }
+
+    // Writes everything buffered; a client that has gone away is ignored.
+    void flush() {
+        size_t written = 0;
+        while (written < pending.size()) {
+            ssize_t n = write(fd, pending.data() + written, pending.size() - written);
+            if (n <= 0) {
+                break;
+            }
+            written += size_t(n);
+        }
+        pending.clear();
+    }
+};
+
+// Coalesces single-row requests from any number of client threads into
+// micro-batches: a batch is sent to the model once maxBatch rows are queued
+// or maxWait has passed since the oldest queued row arrived, whichever comes
+// first. Model needs inputSize(), outputSize() and
+// predictBatch(const T*, size_t, T*) const.
+template<typename T, typename Model>
+class MicroBatcher {
+private:
+    using Clock = chrono::steady_clock;
+
+    enum class Kind { Predict, Stats, Error };
+
+    struct Pending {
+        shared_ptr<ResponseSink> sink;
+        Clock::time_point arrival;
+        Kind kind;
+        string message;
+    };
+
+    const Model& model;
+    const ServerOptions options;
+
+    mutex lock;
+    condition_variable arrived;
+    condition_variable drained;
+    vector<Pending> queue;
+    vector<T> queuedFeatures;
+    size_t predictRows = 0;
+    bool stopping = false;
+
+    // Metrics, guarded by lock.
+    size_t maxQueueDepth = 0;
+    size_t batches = 0;
+    size_t rowsServed = 0;
+    vector<size_t> batchHistogram;
+    vector<double> latencies;
+    size_t latencyCursor = 0;
+    static constexpr size_t latencyWindow = 1 << 16;
+
+    thread worker;
+
+    static size_t histogramBucket(size_t batchSize) {
+        size_t bucket = 0;
+        while ((size_t(1) << bucket) < batchSize) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void appendRow(ResponseSink& sink, const T* values, size_t count) {
+        char text[32];
+        for (size_t i = 0; i < count; ++i) {
+            int length = snprintf(text, sizeof(text), "%.*g", is_same<T, float>::value ? 9 : 17, double(values[i]));
+            sink.append(text, size_t(length));
+            sink.append(i + 1 < count ? "," : "\n", 1);
+        }
+    }
+
+    void run() {
+        const size_t in = model.inputSize();
+        const size_t out = model.outputSize();
+        vector<Pending> batch;
+        vector<T, AlignedAllocator<T>> features(options.maxBatch * in);
+        vector<T, AlignedAllocator<T>> outputs(options.maxBatch * out);
+
+        while (true) {
+            size_t rows = 0;
+            {
+                unique_lock<mutex> guard(lock);
+                arrived.wait(guard, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                const Clock::time_point deadline = queue.front().arrival + options.maxWait;
+                arrived.wait_until(guard, deadline, [&] { return stopping || predictRows >= options.maxBatch; });
+
+                // Take queued entries in order until maxBatch prediction rows.
+                size_t taken = 0;
+                while (taken < queue.size() && (queue[taken].kind != Kind::Predict || rows < options.maxBatch)) {
+                    if (queue[taken].kind == Kind::Predict) {
+                        ++rows;
+                    }
+                    ++taken;
+                }
+                batch.assign(make_move_iterator(queue.begin()), make_move_iterator(queue.begin() + long(taken)));
+                queue.erase(queue.begin(), queue.begin() + long(taken));
+                copy(queuedFeatures.begin(), queuedFeatures.begin() + long(rows * in), features.begin());
+                queuedFeatures.erase(queuedFeatures.begin(), queuedFeatures.begin() + long(rows * in));
+                predictRows -= rows;
+            }
+            drained.notify_all();
+
+            if (rows > 0) {
+                model.predictBatch(features.data(), rows, outputs.data());
+            }
+
+            size_t row = 0;
+            for (Pending& entry : batch) {
+                if (entry.kind == Kind::Predict) {
+                    appendRow(*entry.sink, outputs.data() + row * out, out);
+                    ++row;
+                } else if (entry.kind == Kind::Stats) {
+                    entry.sink->append(metricsJson() + "\n");
+                } else {
+                    entry.sink->append("error: " + entry.message + "\n");
+                }
+            }
+            for (Pending& entry : batch) {
+                entry.sink->flush();
+            }
+
+            const Clock::time_point done = Clock::now();
+            unique_lock<mutex> guard(lock);
+            if (rows > 0) {
+                ++batches;
+                rowsServed += rows;
+                ++batchHistogram[histogramBucket(rows)];
+            }
+            for (const Pending& entry : batch) {
+                if (entry.kind == Kind::Predict) {
+                    const double micros = chrono::duration<double, micro>(done - entry.arrival).count();
+                    if (latencies.size() < latencyWindow) {
+                        latencies.push_back(micros);
+                    } else {
+                        latencies[latencyCursor] = micros;
+                        latencyCursor = (latencyCursor + 1) % latencyWindow;
+                    }
+                }
+            }
+            batch.clear();
+        }
+    }
+
+    void enqueue(Pending entry, const T* features) {
+        unique_lock<mutex> guard(lock);
+        drained.wait(guard, [&] { return stopping || queue.size() < options.maxQueue; });
+        if (entry.kind == Kind::Predict) {
+            queuedFeatures.insert(queuedFeatures.end(), features, features + model.inputSize());
+            ++predictRows;
+        }
+        queue.push_back(move(entry));
+        maxQueueDepth = max(maxQueueDepth, queue.size());
+        if (queue.size() == 1 || predictRows >= options.maxBatch) {
+            arrived.notify_one();
+        }
+    }
+
+public:
+    MicroBatcher(const Model& served, const ServerOptions& serverOptions) : model(served), options(serverOptions), batchHistogram(histogramBucket(max<size_t>(1, serverOptions.maxBatch)) + 1, 0) {
+        worker = thread([this] { run(); });
+    }
+
+    ~MicroBatcher() { shutdown(); }
+
+    MicroBatcher(const MicroBatcher&) = delete;
+    MicroBatcher& operator=(const MicroBatcher&) = delete;
+
+    // Parses one request line and queues it. A line holds inputSize() numbers
+    // separated by commas or whitespace, or the word "stats" for a metrics
+    // snapshot. Blocks while maxQueue requests are already waiting.
+    void submit(const shared_ptr<ResponseSink>& sink, const char* line, size_t length) {
+        while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) {
+            --length;
+        }
+        if (length == 0) {
+            return;
+        }
+        Pending entry{sink, Clock::now(), Kind::Predict, string()};
+        if (length == 5 && memcmp(line, "stats", 5) == 0) {
+            entry.kind = Kind::Stats;
+            enqueue(move(entry), nullptr);
+            return;
+        }
+
+        static thread_local vector<T> features;
+        features.clear();
+        const char* p = line;
+        const char* end = line + length;
+        while (p < end) {
+            while (p < end && (*p == ',' || *p == ' ' || *p == '\t')) ++p;
+            if (p == end) break;
+            double value = 0.0;
+            from_chars_result parsed = from_chars(p, end, value);
+            if (parsed.ec != errc()) {
+                entry.kind = Kind::Error;
+                entry.message = "invalid number";
+                break;
+            }
+            features.push_back(T(value));
+            p = parsed.ptr;
+        }
+        if (entry.kind == Kind::Predict && features.size() != model.inputSize()) {
+            entry.kind = Kind::Error;
+            entry.message = "expected " + to_string(model.inputSize()) + " values, got " + to_string(features.size());
+        }
+        enqueue(move(entry), features.data());
+    }
+
+    // Serves everything already queued, then stops the batching thread.
+    void shutdown() {
+        {
+            unique_lock<mutex> guard(lock);
+            stopping = true;
+        }
+        arrived.notify_all();
+        drained.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Queue depth, batch-size histogram (bucket k counts batches of
+    // 2^(k-1)+1 .. 2^k rows) and latency percentiles in microseconds over the
+    // most recent requests, from arrival to response written.
+    string metricsJson() {
+        unique_lock<mutex> guard(lock);
+        vector<double> sorted = latencies;
+        sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) {
+            return sorted.empty() ? 0.0 : sorted[min(sorted.size() - 1, size_t(p * double(sorted.size())))];
+        };
+
+        string json = "{\"queue_depth\":" + to_string(queue.size()) + ",\"max_queue_depth\":" + to_string(maxQueueDepth) + ",\"batches\":" + to_string(batches) + ",\"rows\":" + to_string(rowsServed) + ",\"mean_batch\":" + to_string(batches > 0 ? double(rowsServed) / double(batches) : 0.0) + ",\"batch_histogram\":{";
+        for (size_t bucket = 0; bucket < batchHistogram.size(); ++bucket) {
+            json += "\"<=" + to_string(size_t(1) << bucket) + "\":" + to_string(batchHistogram[bucket]) + (bucket + 1 < batchHistogram.size() ? "," : "");
+        }
+        json += "},\"latency_us\":{\"p50\":" + to_string(percentile(0.5)) + ",\"p90\":" + to_string(percentile(0.9)) + ",\"p99\":" + to_string(percentile(0.99)) + ",\"max\":" + to_string(sorted.empty() ? 0.0 : sorted.back()) + "}}";
+        return json;
+    }
+};
+
+#endif // INFERENCE_SERVER_H
@@ -2,195 +2,1109 @@
 #define MLP_H
 
 #include <cmath>
+#include <random>
 #include <vector>
+#include <limits>
+#include <numeric>
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 #include "Matrix.h"
+#include "ThreadPool.h"
+#include "Checkpoint.h"
+#include "Optimizer.h"
+#include "Metrics.h"
+#include "SparseMatrix.h"
+#include "Random.h"
+#include "DataStream.h"
 
 using namespace std;
 
+// Early stopping for trainWithValidation. Every interval epochs the
+// validation loss is compared with the best so far (the training loss when
+// the validation set is empty); training stops once it has gone patience
+// epochs without improving by more than minDelta. patience 0 turns it off.
+// Checks fall on multiples of interval in the model's epoch count, and the
+// best loss so far carries across calls and checkpoints, so training in
+// chunks or resuming stops where one long call would.
+struct EarlyStopping {
+    int patience = 0;
+    double minDelta = 1e-4;
+    int interval = 10;
+    // Puts back the parameters from the best check when training stops.
+    bool restoreBest = true;
+};
+
+// Starting parameters. Uniform draws weights and biases from U(-1, 1), the
+// original scheme. The others scale the weights by the layer's fan-in and
+// fan-out and start biases at zero:
+//   XavierUniform  U(-a, a), a = sqrt(6 / (fanIn + fanOut))
+//   XavierNormal   N(0, 2 / (fanIn + fanOut))
+//   HeUniform      U(-a, a), a = sqrt(6 / fanIn)
+//   HeNormal       N(0, 2 / fanIn)
+enum class InitScheme { Uniform, XavierUniform, XavierNormal, HeUniform, HeNormal };
+
+// Layer i's weights are Philox stream 2i and its biases stream 2i + 1,
+// indexed by row-major position, so the seed alone fixes every parameter.
+struct InitConfig {
+    InitScheme scheme = InitScheme::Uniform;
+    uint64_t seed = 0;
+};
+
+inline const char* initSchemeName(InitScheme scheme) {
+    switch (scheme) {
+        case InitScheme::XavierUniform: return "xavier-uniform";
+        case InitScheme::XavierNormal: return "xavier-normal";
+        case InitScheme::HeUniform: return "he-uniform";
+        case InitScheme::HeNormal: return "he-normal";
+        default: return "uniform";
+    }
+}
+
+// Positions [first, first + count) of one layer's weights (or biases) under
+// config; fanIn and fanOut are the layer's input and output widths.
+template<typename T>
+void initialParameters(const InitConfig& config, size_t layer, bool bias, size_t fanIn, size_t fanOut, uint64_t first, size_t count, T* out) {
+    const uint64_t stream = 2 * uint64_t(layer) + (bias ? 1 : 0);
+    if (config.scheme == InitScheme::Uniform) {
+        philoxUniform(config.seed, stream, first, count, T(-1.0), T(1.0), out);
+        return;
+    }
+    if (bias) {
+        fill(out, out + count, T{});
+        return;
+    }
+    const double sum = double(fanIn + fanOut);
+    switch (config.scheme) {
+        case InitScheme::XavierUniform: {
+            const T limit = T(sqrt(6.0 / sum));
+            philoxUniform(config.seed, stream, first, count, -limit, limit, out);
+            return;
+        }
+        case InitScheme::XavierNormal:
+            philoxNormal(config.seed, stream, first, count, T{}, T(sqrt(2.0 / sum)), out);
+            return;
+        case InitScheme::HeUniform: {
+            const T limit = T(sqrt(6.0 / double(fanIn)));
+            philoxUniform(config.seed, stream, first, count, -limit, limit, out);
+            return;
+        }
+        default:
+            philoxNormal(config.seed, stream, first, count, T{}, T(sqrt(2.0 / double(fanIn))), out);
+            return;
+    }
+}
+
 template<typename T>
 class MLP {
+public:
+    // Loss and gradient sums over a dataset. float models keep these in
+    // double so storage and GEMMs run at float width without the sums
+    // drifting over thousands of samples.
+    using Accumulator = typename conditional<is_same<T, float>::value, double, T>::type;
+
 private:
     vector<Matrix<T>> weights;
     vector<Matrix<T>> biases;
     vector<int> layerSizes;
     T learningRate;
+    size_t batchSize;
+    size_t threadCount;
+    blas::SigmoidMode sigmoidMode;
+
+    size_t maxLayerWidth;
 
-    Matrix<T> sigmoid(Matrix<T> input) {
-        Matrix<T> result(input.getRows(), input.getCols());
-        for (size_t i = 0; i < input.getRows(); ++i) {
-            for (size_t j = 0; j < input.getCols(); ++j) {
-                result.set(i, j, T(1.0) / (T(1.0) + T(exp(-double(input(i, j))))));
+    Optimizer<T> optimizer;
+    bool miniBatches = false;
+    uint64_t shuffleSeed = 0;
+
+    EarlyStopping earlyStopping;
+    bool stoppedEarly = false;
+    // Early-stopping progress. It carries across training calls and
+    // checkpoints, and restarts when the parameters are replaced.
+    Accumulator bestLoss = numeric_limits<Accumulator>::infinity();
+    uint64_t epochsSinceBest = 0;
+    vector<Matrix<T>> bestWeights;
+    vector<Matrix<T>> bestBiases;
+
+    uint64_t epochsTrained = 0;
+    string checkpointPath;
+    int checkpointInterval = 0;
+
+    // Pruning masks, one per layer with 1 where a weight trains and 0 where
+    // it is held at zero; empty for a dense model.
+    vector<Matrix<T>> weightMasks;
+    // CSR copies of the layers whose zero fraction reaches sparseThreshold.
+    // Inference uses them in place of the dense GEMM; training does not, as
+    // the weights change every step. Rebuilt whenever weights are replaced
+    // or a training call ends.
+    vector<CsrMatrix<T>> sparseWeights;
+    double sparseThreshold = 0.6;
+
+    // Layer i as the shared forward pass (headers/Inference.h) reads it.
+    inference::Layer<T> layer(size_t i) const {
+        return {weights[i].getData(), biases[i].getData(), weights[i].getRows(), weights[i].getCols(), isSparse(i) ? &sparseWeights[i] : nullptr};
+    }
+
+    // Packed blocks for computeMetrics, kept apart from inference::scratch so a
+    // thread can score and predict without the two sharing storage.
+    static T* evaluationScratch(size_t count) {
+        static thread_local vector<T, AlignedAllocator<T>> scratch;
+        if (scratch.size() < count) {
+            scratch.resize(count);
+        }
+        return scratch.data();
+    }
+
+    bool isSparse(size_t layer) const { return !sparseWeights.empty() && !sparseWeights[layer].empty(); }
+
+    bool hasSparseLayers() const {
+        for (size_t i = 0; i < sparseWeights.size(); ++i) {
+            if (isSparse(i)) {
+                return true;
             }
         }
-        return result;
+        return false;
     }
 
-    Matrix<T> sigmoidDerivative(Matrix<T> sigmoid_output) {
-        Matrix<T> result(sigmoid_output.getRows(), sigmoid_output.getCols());
-        for (size_t i = 0; i < sigmoid_output.getRows(); ++i) {
-            for (size_t j = 0; j < sigmoid_output.getCols(); ++j) {
-                T s = sigmoid_output(i, j);
-                result.set(i, j, s * (T(1.0) - s));
+    void refreshSparseLayers() {
+        sparseWeights.assign(weights.size(), CsrMatrix<T>());
+        for (size_t i = 0; i < weights.size(); ++i) {
+            if (getWeightSparsity(i) >= sparseThreshold) {
+                sparseWeights[i] = CsrMatrix<T>(weights[i]);
             }
         }
-        return result;
     }
 
-public:
-    MLP(vector<int> layers, T lr = T(0.01)) : layerSizes(layers), learningRate(lr) {
-        
-        for (size_t i = 0; i < layers.size() - 1; ++i) {
-            Matrix<T> w(layers[i + 1], layers[i]);
-            Matrix<T> b(layers[i + 1], 1);
-            
-            w.randomize();
-            b.randomize();
-            
-            weights.push_back(w);
-            biases.push_back(b);
+    void maskWeights(size_t layer) {
+        T* w = weights[layer].getData();
+        const T* mask = weightMasks[layer].getData();
+        for (size_t k = 0; k < weights[layer].size(); ++k) {
+            if (mask[k] == T{}) {
+                w[k] = T{};
+            }
         }
     }
 
-    Matrix<T> forward(Matrix<T> input) {
-        Matrix<T> activation = input;
-        
+    // Packed columns through every layer: buffers[0] holds count inputs at
+    // stride ld, the layers ping-pong between the two buffers, and the one
+    // holding the outputs is returned.
+    T* forwardColumns(T* const buffers[2], size_t count, size_t ld) const {
         for (size_t i = 0; i < weights.size(); ++i) {
-            Matrix<T> linear = weights[i] * activation + biases[i];
-            activation = sigmoid(linear);
+            const T* current = buffers[i % 2];
+            T* next = buffers[(i + 1) % 2];
+            if (isSparse(i)) {
+                sparseWeights[i].multiply(count, current, ld, next, ld);
+            } else {
+                blas::gemm(weights[i].getRows(), count, weights[i].getCols(), weights[i].getData(), weights[i].getCols(), current, ld, next, ld);
+            }
+            for (size_t j = 0; j < weights[i].getRows(); ++j) {
+                blas::sigmoid(count, next + j * ld, biases[i](j, 0), static_cast<T*>(nullptr), sigmoidMode);
+            }
         }
-        
-        return activation;
+        return buffers[weights.size() % 2];
     }
 
-    void trainWithValidation(vector<Matrix<T>> trainInputs, vector<Matrix<T>> trainTargets, vector<Matrix<T>> valInputs, vector<Matrix<T>> valTargets, int epochs, bool verbose = true) {
-        
-        for (int epoch = 0; epoch < epochs; ++epoch) {
-            T totalLoss = T{};
-            
-            vector<Matrix<T>> weightGradients;
-            vector<Matrix<T>> biasGradients;
-            
-            for (size_t i = 0; i < weights.size(); ++i) {
-                weightGradients.push_back(Matrix<T>(weights[i].getRows(), weights[i].getCols()));
-                biasGradients.push_back(Matrix<T>(biases[i].getRows(), biases[i].getCols()));
-            }
-            
-            for (size_t sample = 0; sample < trainInputs.size(); ++sample) {
-                vector<Matrix<T>> activations;
-                vector<Matrix<T>> linearOutputs;
-                
-                Matrix<T> activation = trainInputs[sample];
-                activations.push_back(activation);
-                
-                for (size_t i = 0; i < weights.size(); ++i) {
-                    Matrix<T> linear = weights[i] * activation + biases[i];
-                    linearOutputs.push_back(linear);
-                    activation = sigmoid(linear);
-                    activations.push_back(activation);
+    static size_t sampleCount(const vector<Matrix<T>>& samples) { return samples.size(); }
+    static size_t sampleCount(const MatrixView<const T>& samples) { return samples.getRows(); }
+
+    // Checks a training or validation set once per call, so packBatch can
+    // read it without bounds checks.
+    void checkSamples(const vector<Matrix<T>>& inputs, const vector<Matrix<T>>& targets) const {
+        if (targets.size() != inputs.size()) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+        for (size_t s = 0; s < inputs.size(); ++s) {
+            if (inputs[s].size() != inputSize() || targets[s].size() != outputSize()) {
+                throw invalid_argument("Sample size does not match the network's layer size");
+            }
+        }
+    }
+
+    void checkSamples(const MatrixView<const T>& inputs, const MatrixView<const T>& targets) const {
+        if (inputs.getCols() != inputSize() || targets.getCols() != outputSize()) {
+            throw invalid_argument("Sample views do not match the network's layer sizes");
+        }
+        if (targets.getRows() != inputs.getRows()) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+    }
+
+    // Copies samples [first, first + count) into the leading columns of batch.
+    // With an order, position p stands for sample order[p] instead.
+    void packBatch(const vector<Matrix<T>>& samples, const size_t* order, size_t first, size_t count, Matrix<T>& batch) const {
+        const size_t ld = batch.getCols();
+        T* dst = batch.getData();
+        for (size_t b = 0; b < count; ++b) {
+            const T* src = samples[order != nullptr ? order[first + b] : first + b].getData();
+            for (size_t i = 0; i < batch.getRows(); ++i) {
+                dst[i * ld + b] = src[i];
+            }
+        }
+    }
+
+    // Same, for samples stored one per row of a (possibly mapped) view.
+    void packBatch(const MatrixView<const T>& samples, const size_t* order, size_t first, size_t count, Matrix<T>& batch) const {
+        const size_t ld = batch.getCols();
+        T* dst = batch.getData();
+        for (size_t b = 0; b < count; ++b) {
+            const size_t sample = order != nullptr ? order[first + b] : first + b;
+            for (size_t i = 0; i < batch.getRows(); ++i) {
+                dst[i * ld + b] = samples(sample, i);
+            }
+        }
+    }
+
+    // Copies samples [first, first + count) into the leading columns of a
+    // height x ld block, as packBatch does for training.
+    static void gatherColumns(const vector<Matrix<T>>& samples, size_t first, size_t count, size_t height, size_t ld, T* block) {
+        for (size_t b = 0; b < count; ++b) {
+            const Matrix<T>& sample = samples[first + b];
+            if (sample.size() != height) {
+                throw invalid_argument("Sample size does not match the network's layer size");
+            }
+            for (size_t i = 0; i < height; ++i) {
+                block[i * ld + b] = sample.getData()[i];
+            }
+        }
+    }
+
+    static void gatherColumns(const MatrixView<const T>& samples, size_t first, size_t count, size_t height, size_t ld, T* block) {
+        for (size_t b = 0; b < count; ++b) {
+            for (size_t i = 0; i < height; ++i) {
+                block[i * ld + b] = samples(first + b, i);
+            }
+        }
+    }
+
+    // Blocks of samples are packed as columns, as in training, so every layer
+    // is one blocked GEMM; each block is scored into its own totals and blocks
+    // run on up to threadCount threads.
+    template<typename Samples>
+    Metrics<T> metricsPass(const Samples& inputs, const Samples& targets, bool perOutput, T threshold) const {
+        constexpr size_t blockCols = 256;
+        const size_t total = sampleCount(inputs);
+        if (sampleCount(targets) != total) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+        const size_t blocks = (total + blockCols - 1) / blockCols;
+        vector<MetricTotals<T, Accumulator>> partial(blocks, MetricTotals<T, Accumulator>(outputSize(), perOutput));
+
+        auto scoreBlock = [&](size_t block) {
+            const size_t first = block * blockCols;
+            const size_t count = min(blockCols, total - first);
+            // Targets, then two ping-pong activation blocks of the widest layer.
+            T* stagedTargets = evaluationScratch((outputSize() + 2 * maxLayerWidth) * blockCols);
+            T* buffers[2] = {stagedTargets + outputSize() * blockCols, stagedTargets + (outputSize() + maxLayerWidth) * blockCols};
+            gatherColumns(inputs, first, count, inputSize(), blockCols, buffers[0]);
+            gatherColumns(targets, first, count, outputSize(), blockCols, stagedTargets);
+
+            const T* outputs = forwardColumns(buffers, count, blockCols);
+            partial[block].add(outputs, stagedTargets, count, outputSize(), blockCols, threshold);
+        };
+
+        const size_t workers = min(threadCount, blocks);
+        if (workers > 1) {
+            ThreadPool pool(workers);
+            pool.parallelFor(blocks, scoreBlock);
+        } else {
+            for (size_t block = 0; block < blocks; ++block) {
+                scoreBlock(block);
+            }
+        }
+
+        MetricTotals<T, Accumulator> totals(outputSize(), perOutput);
+        for (const auto& block : partial) {
+            totals.merge(block);
+        }
+        return totals.finish();
+    }
+
+    // activations[0] holds the packed inputs; every later entry receives
+    // sigmoid(W * previous + b) for the first count columns. When derivatives
+    // is given, derivatives[i] receives s * (1 - s) for activations[i + 1]
+    // from the same sigmoid pass.
+    void forwardBatch(vector<Matrix<T>>& activations, vector<Matrix<T>>* derivatives, size_t count) const {
+        const size_t ld = activations[0].getCols();
+        for (size_t i = 0; i < weights.size(); ++i) {
+            Matrix<T>& out = activations[i + 1];
+            PROFILE_LAYER(i, 2 * weights[i].size() * count, sizeof(T) * (weights[i].size() + (weights[i].getCols() + 2 * weights[i].getRows()) * count));
+            blas::gemm(weights[i].getRows(), count, weights[i].getCols(), weights[i].getData(), weights[i].getCols(), activations[i].getData(), ld, out.getData(), ld);
+
+            for (size_t j = 0; j < out.getRows(); ++j) {
+                T* derivativeRow = derivatives != nullptr ? (*derivatives)[i].getData() + j * ld : nullptr;
+                blas::sigmoid(count, out.getData() + j * ld, biases[i](j, 0), derivativeRow, sigmoidMode);
+            }
+        }
+    }
+
+    // Writes 2 * (output - target) * s'(output) into delta and returns the
+    // batch's summed squared error.
+    Accumulator outputDeltas(const Matrix<T>& output, const Matrix<T>& derivative, const Matrix<T>& targets, Matrix<T>& delta, size_t count) const {
+        const size_t ld = output.getCols();
+        Accumulator loss = Accumulator{};
+        for (size_t b = 0; b < count; ++b) {
+            for (size_t i = 0; i < output.getRows(); ++i) {
+                const T error = output.getData()[i * ld + b] - targets.getData()[i * ld + b];
+                loss += Accumulator(error) * Accumulator(error);
+                delta.getData()[i * ld + b] = T(2.0) * error * derivative.getData()[i * ld + b];
+            }
+        }
+        return loss;
+    }
+
+    // deltas[i] = (W[i + 1]^T * deltas[i + 1]) .* derivatives[i], with the
+    // derivative applied as each delta tile leaves registers.
+    void backwardBatch(const vector<Matrix<T>>& derivatives, vector<Matrix<T>>& deltas, size_t count) const {
+        const size_t ld = deltas[0].getCols();
+        for (int i = int(weights.size()) - 2; i >= 0; --i) {
+            const Matrix<T>& next = weights[i + 1];
+            PROFILE_LAYER(size_t(i) + 1, 2 * next.size() * count, sizeof(T) * (next.size() + (next.getRows() + 2 * next.getCols()) * count));
+            blas::gemmTNHadamard(next.getCols(), count, next.getRows(), next.getData(), next.getCols(), deltas[i + 1].getData(), ld, derivatives[i].getData(), ld, deltas[i].getData(), ld);
+        }
+    }
+
+    // Scratch owned by one training worker: its packed batch buffers and its
+    // own gradient accumulators, so workers never write to shared memory.
+    struct Workspace {
+        vector<Matrix<T>> activations;
+        vector<Matrix<T>> derivatives;
+        vector<Matrix<T>> deltas;
+        // Each layer's input activations transposed to samples x features,
+        // so a batch's weight gradient is one blocked GEMM: the sum of the
+        // per-sample outer products delta * a^T.
+        vector<Matrix<T>> transposedInputs;
+        Matrix<T> targets;
+        vector<Matrix<Accumulator>> weightGradients;
+        vector<Matrix<Accumulator>> biasGradients;
+        // One batch's weight gradients, when they are summed at T width
+        // before being added to the wider accumulators.
+        vector<Matrix<T>> batchGradients;
+        Accumulator loss = Accumulator{};
+    };
+
+    vector<Workspace> workspaces;
+
+    Workspace makeWorkspace(size_t batchCols) const {
+        Workspace ws;
+        ws.activations.push_back(Matrix<T>(layerSizes[0], batchCols));
+        for (size_t i = 0; i < weights.size(); ++i) {
+            ws.activations.push_back(Matrix<T>(layerSizes[i + 1], batchCols));
+            ws.derivatives.push_back(Matrix<T>(layerSizes[i + 1], batchCols));
+            ws.deltas.push_back(Matrix<T>(layerSizes[i + 1], batchCols));
+            ws.transposedInputs.push_back(Matrix<T>(batchCols, layerSizes[i]));
+            ws.weightGradients.push_back(Matrix<Accumulator>(weights[i].getRows(), weights[i].getCols()));
+            ws.biasGradients.push_back(Matrix<Accumulator>(biases[i].getRows(), biases[i].getCols()));
+            if (!is_same<T, Accumulator>::value) {
+                ws.batchGradients.push_back(Matrix<T>(weights[i].getRows(), weights[i].getCols()));
+            }
+        }
+        ws.targets = Matrix<T>(layerSizes.back(), batchCols);
+        return ws;
+    }
+
+    // Sizes the per-worker workspaces from layerSizes. They are kept across
+    // trainWithValidation calls and only rebuilt when the worker count or
+    // batch width changes, so the epoch loop itself never allocates.
+    void prepareWorkspaces(size_t workerCount, size_t batchCols) {
+        if (workspaces.size() == workerCount && !workspaces.empty() && workspaces[0].targets.getCols() == batchCols) {
+            return;
+        }
+        workspaces.clear();
+        for (size_t w = 0; w < workerCount; ++w) {
+            workspaces.push_back(makeWorkspace(batchCols));
+        }
+    }
+
+    // Mean squared error over a dataset, pushed through ws in batches; 0 for
+    // an empty set, as in Metrics.
+    template<typename Samples>
+    T batchedLoss(Workspace& ws, const Samples& inputs, const Samples& targets) const {
+        const size_t batchCols = ws.targets.getCols();
+        const size_t ld = batchCols;
+        Accumulator totalLoss = Accumulator{};
+
+        const size_t total = sampleCount(inputs);
+        if (total == 0) {
+            return T{};
+        }
+        for (size_t first = 0; first < total; first += batchCols) {
+            const size_t count = min(batchCols, total - first);
+            packBatch(inputs, nullptr, first, count, ws.activations[0]);
+            packBatch(targets, nullptr, first, count, ws.targets);
+            forwardBatch(ws.activations, nullptr, count);
+
+            const Matrix<T>& output = ws.activations.back();
+            for (size_t b = 0; b < count; ++b) {
+                for (size_t i = 0; i < output.getRows(); ++i) {
+                    const T error = output.getData()[i * ld + b] - ws.targets.getData()[i * ld + b];
+                    totalLoss += Accumulator(error) * Accumulator(error);
                 }
-                
-                Matrix<T> error = activations.back() - trainTargets[sample];
-                for (size_t i = 0; i < error.getRows(); ++i) {
-                    for (size_t j = 0; j < error.getCols(); ++j) {
-                        totalLoss += error(i, j) * error(i, j);
+            }
+        }
+
+        return T(totalLoss * (Accumulator(1.0) / Accumulator(total)));
+    }
+
+    // Runs forward and backward over samples [begin, end) (positions in order
+    // when given) in batches and leaves the summed loss and gradients in ws,
+    // or adds them to what ws already holds with accumulate. Reads weights
+    // only.
+    template<typename Samples>
+    void trainShard(Workspace& ws, const Samples& inputs, const Samples& targets, const size_t* order, size_t begin, size_t end, bool accumulate = false) const {
+        const size_t batchCols = ws.targets.getCols();
+
+        if (!accumulate) {
+            ws.loss = Accumulator{};
+            for (size_t i = 0; i < weights.size(); ++i) {
+                ws.weightGradients[i].fill(Accumulator{});
+                ws.biasGradients[i].fill(Accumulator{});
+            }
+        }
+
+        for (size_t first = begin; first < end; first += batchCols) {
+            const size_t count = min(batchCols, end - first);
+
+            {
+                PROFILE_SCOPE(Pack);
+                packBatch(inputs, order, first, count, ws.activations[0]);
+                packBatch(targets, order, first, count, ws.targets);
+            }
+            {
+                PROFILE_SCOPE(Forward);
+                forwardBatch(ws.activations, &ws.derivatives, count);
+            }
+            {
+                PROFILE_SCOPE(Backward);
+                ws.loss += outputDeltas(ws.activations.back(), ws.derivatives.back(), ws.targets, ws.deltas.back(), count);
+                backwardBatch(ws.derivatives, ws.deltas, count);
+            }
+
+            PROFILE_SCOPE(Gradients);
+            for (size_t i = 0; i < weights.size(); ++i) {
+                PROFILE_LAYER(i, 2 * weights[i].size() * count, sizeof(T) * (2 * weights[i].size() + (weights[i].getRows() + weights[i].getCols()) * count));
+                const size_t cols = weights[i].getCols();
+                const T* input = ws.activations[i].getData();
+                T* transposed = ws.transposedInputs[i].getData();
+                for (size_t k = 0; k < cols; ++k) {
+                    for (size_t b = 0; b < count; ++b) {
+                        transposed[b * cols + k] = input[k * batchCols + b];
                     }
                 }
-                
-                vector<Matrix<T>> deltas(weights.size());
-                
-                Matrix<T> outputSigmoidDeriv = sigmoidDerivative(activations.back());
-                deltas[deltas.size() - 1] = Matrix<T>(error.getRows(), error.getCols());
-                for (size_t i = 0; i < error.getRows(); ++i) {
-                    for (size_t j = 0; j < error.getCols(); ++j) {
-                        deltas[deltas.size() - 1].set(i, j, T(2.0) * error(i, j) * outputSigmoidDeriv(i, j));
-                    }
+                if constexpr (is_same<T, Accumulator>::value) {
+                    blas::gemm(weights[i].getRows(), cols, count, ws.deltas[i].getData(), batchCols, transposed, cols, ws.weightGradients[i].getData(), cols, true);
+                } else {
+                    blas::gemm(weights[i].getRows(), cols, count, ws.deltas[i].getData(), batchCols, transposed, cols, ws.batchGradients[i].getData(), cols);
+                    addInto(ws.weightGradients[i], ws.batchGradients[i]);
                 }
-                
-                for (int i = weights.size() - 2; i >= 0; --i) {
-                    Matrix<T> sigmoidDeriv = sigmoidDerivative(activations[i + 1]);
-                    deltas[i] = Matrix<T>(weights[i + 1].getCols(), 1);
-                    
-                    for (size_t j = 0; j < deltas[i].getRows(); ++j) {
-                        T sum = T{};
-                        for (size_t k = 0; k < weights[i + 1].getRows(); ++k) {
-                            sum += weights[i + 1](k, j) * deltas[i + 1](k, 0);
-                        }
-                        deltas[i].set(j, 0, sum * sigmoidDeriv(j, 0));
+
+                for (size_t j = 0; j < ws.deltas[i].getRows(); ++j) {
+                    const T* deltaRow = ws.deltas[i].getData() + j * batchCols;
+                    T sum = T{};
+                    for (size_t b = 0; b < count; ++b) {
+                        sum += deltaRow[b];
                     }
+                    ws.biasGradients[i](j, 0) += Accumulator(sum);
+                }
+            }
+        }
+    }
+
+    template<typename Target, typename Source>
+    static void addInto(Matrix<Target>& target, const Matrix<Source>& source) {
+        Target* dst = target.getData();
+        const Source* src = source.getData();
+        for (size_t i = 0; i < target.size(); ++i) {
+            dst[i] += Target(src[i]);
+        }
+    }
+
+    // Folds every workspace into workspaces[0] by pairwise tree reduction. The
+    // pairing depends only on the worker count, so a fixed thread count always
+    // sums in the same order.
+    void reduceWorkspaces(ThreadPool& pool) {
+        PROFILE_SCOPE(Reduce);
+        for (size_t stride = 1; stride < workspaces.size(); stride *= 2) {
+            const size_t pairs = (workspaces.size() + 2 * stride - 1) / (2 * stride);
+            pool.parallelFor(pairs, [&](size_t pair) {
+                const size_t left = pair * 2 * stride;
+                const size_t right = left + stride;
+                if (right >= workspaces.size()) {
+                    return;
                 }
-                
                 for (size_t i = 0; i < weights.size(); ++i) {
-                    for (size_t j = 0; j < weights[i].getRows(); ++j) {
-                        for (size_t k = 0; k < weights[i].getCols(); ++k) {
-                            T gradient = deltas[i](j, 0) * activations[i](k, 0);
-                            weightGradients[i].set(j, k, weightGradients[i](j, k) + gradient);
-                        }
-                        biasGradients[i].set(j, 0, biasGradients[i](j, 0) + deltas[i](j, 0));
-                    }
+                    addInto(workspaces[left].weightGradients[i], workspaces[right].weightGradients[i]);
+                    addInto(workspaces[left].biasGradients[i], workspaces[right].biasGradients[i]);
                 }
+                workspaces[left].loss += workspaces[right].loss;
+            });
+        }
+    }
+
+    // One optimizer step with the gradients summed over totalSamples samples
+    // in ws. Layer i's weights are optimizer slot 2i, its biases 2i + 1.
+    void applyGradients(const Workspace& ws, Accumulator totalSamples, T rate) {
+        PROFILE_SCOPE(Update);
+        const Accumulator scale = Accumulator(1.0) / totalSamples;
+        optimizer.beginStep();
+        for (size_t i = 0; i < weights.size(); ++i) {
+            optimizer.step(2 * i, weights[i].getData(), ws.weightGradients[i].getData(), weights[i].size(), scale, rate);
+            if (!weightMasks.empty()) {
+                maskWeights(i);
             }
-            
-            T sampleCount = T(trainInputs.size());
-            for (size_t i = 0; i < weights.size(); ++i) {
-                for (size_t j = 0; j < weights[i].getRows(); ++j) {
-                    for (size_t k = 0; k < weights[i].getCols(); ++k) {
-                        T avgGradient = weightGradients[i](j, k) * (T(1.0) / sampleCount);
-                        weights[i].set(j, k, weights[i](j, k) - learningRate * avgGradient);
+            optimizer.step(2 * i + 1, biases[i].getData(), ws.biasGradients[i].getData(), biases[i].size(), scale, rate);
+        }
+    }
+
+    // Forgets early-stopping progress made with parameters that have since
+    // been replaced.
+    void resetEarlyStopping() {
+        bestLoss = numeric_limits<Accumulator>::infinity();
+        epochsSinceBest = 0;
+    }
+
+    // Copies parameters between equally shaped matrices without reallocating.
+    static void copyParameters(const vector<Matrix<T>>& from, vector<Matrix<T>>& to) {
+        for (size_t i = 0; i < from.size(); ++i) {
+            copy(from[i].getData(), from[i].getData() + from[i].size(), to[i].getData());
+        }
+    }
+
+    vector<size_t> parameterSlotSizes() const {
+        vector<size_t> sizes;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            sizes.push_back(weights[i].size());
+            sizes.push_back(biases[i].size());
+        }
+        return sizes;
+    }
+
+    // The epoch loop shared by the training entry points: learning-rate
+    // schedule, early stopping, progress output and checkpoints.
+    // runEpoch(rate) trains one epoch and returns its summed loss and sample
+    // count. Returns the epochs run, fewer than epochs when early stopping
+    // ends training.
+    template<typename Samples, typename RunEpoch>
+    int runEpochs(const Samples& valInputs, const Samples& valTargets, int epochs, bool verbose, RunEpoch runEpoch) {
+        const bool stopEarly = earlyStopping.patience > 0;
+        const bool monitorValidation = sampleCount(valInputs) > 0;
+        const int checkInterval = max(1, earlyStopping.interval);
+        bool stopped = false;
+        if (stopEarly && earlyStopping.restoreBest && bestWeights.size() != weights.size()) {
+            bestWeights = weights;
+            bestBiases = biases;
+        }
+        PROFILE_BEGIN_TRAINING();
+
+        int epoch = 0;
+        for (; epoch < epochs && !stopped; ++epoch) {
+            const T rate = T(scheduledRate(optimizer.getConfig(), double(learningRate), epochsTrained));
+            const pair<Accumulator, size_t> result = runEpoch(rate);
+            // Mean training loss, 0 when there were no samples.
+            const Accumulator trainLoss = result.second > 0 ? result.first / Accumulator(result.second) : Accumulator{};
+
+            // Checks fall on the model's epoch count, so a resumed run checks
+            // on the same epochs as an uninterrupted one.
+            if (stopEarly && (epochsTrained + 1) % uint64_t(checkInterval) == 0) {
+                PROFILE_SCOPE(Validation);
+                // The training loss is summed before this epoch's last step;
+                // that lag does not matter for a plateau check.
+                const Accumulator monitored = monitorValidation ? Accumulator(batchedLoss(workspaces[0], valInputs, valTargets)) : trainLoss;
+                if (monitored < bestLoss - Accumulator(earlyStopping.minDelta)) {
+                    bestLoss = monitored;
+                    epochsSinceBest = 0;
+                    if (earlyStopping.restoreBest) {
+                        copyParameters(weights, bestWeights);
+                        copyParameters(biases, bestBiases);
                     }
-                    T avgBiasGradient = biasGradients[i](j, 0) * (T(1.0) / sampleCount);
-                    biases[i].set(j, 0, biases[i](j, 0) - learningRate * avgBiasGradient);
+                } else {
+                    epochsSinceBest += uint64_t(checkInterval);
+                    stopped = epochsSinceBest >= uint64_t(earlyStopping.patience);
                 }
             }
-            
+
             if (verbose && epoch % 100 == 0) {
-                T trainLoss = totalLoss * (T(1.0) / sampleCount);
-                T valLoss = evaluate(valInputs, valTargets);
-                cout << "Epoch " << epoch << " - Train Loss: " << trainLoss << ", Val Loss: " << valLoss << endl;
+                PROFILE_SCOPE(Validation);
+                cout << "Epoch " << epoch << " - Train Loss: " << T(trainLoss);
+                if (monitorValidation) {
+                    cout << ", Val Loss: " << batchedLoss(workspaces[0], valInputs, valTargets);
+                }
+                cout << endl;
+            }
+
+            if (stopped && earlyStopping.restoreBest && bestLoss < numeric_limits<Accumulator>::infinity()) {
+                copyParameters(bestWeights, weights);
+                copyParameters(bestBiases, biases);
             }
+            stoppedEarly = stopped;
+
+            ++epochsTrained;
+            if (checkpointInterval > 0 && (epochsTrained % uint64_t(checkpointInterval) == 0 || epoch + 1 == epochs || stopped)) {
+                PROFILE_SCOPE(Checkpoint);
+                saveCheckpoint(checkpointPath);
+            }
+            PROFILE_EPOCH(epochsTrained, result.second, weights.size());
+        }
+        if (verbose && stopped) {
+            cout << "Stopped early after " << epoch << " epochs" << endl;
         }
+        refreshSparseLayers();
+        return epoch;
     }
 
-    T evaluate(vector<Matrix<T>> testInputs, vector<Matrix<T>> testTargets) {
-        T totalLoss = T{};
-        
-        for (size_t sample = 0; sample < testInputs.size(); ++sample) {
-            Matrix<T> output = forward(testInputs[sample]);
-            Matrix<T> error = output - testTargets[sample];
-            
-            for (size_t i = 0; i < error.getRows(); ++i) {
-                for (size_t j = 0; j < error.getCols(); ++j) {
-                    totalLoss += error(i, j) * error(i, j);
+    // Training runs over batches of up to batchSize samples packed as the
+    // columns of an N x B matrix, so every layer is one GEMM per batch.
+    // Full-batch mode sums gradients over the whole set and takes one
+    // optimizer step per epoch. Mini-batch mode shuffles the samples each
+    // epoch and steps after every batchSize of them. Either way, with several
+    // threads each step's samples are split into contiguous worker shards
+    // whose gradients are tree-reduced.
+    template<typename Samples>
+    int train(const Samples& trainInputs, const Samples& trainTargets, const Samples& valInputs, const Samples& valTargets, int epochs, bool verbose) {
+        checkSamples(trainInputs, trainTargets);
+        checkSamples(valInputs, valTargets);
+        const size_t sampleTotal = sampleCount(trainInputs);
+        const size_t stepSamples = miniBatches ? max<size_t>(1, min(batchSize, sampleTotal)) : sampleTotal;
+        const size_t workerCount = max<size_t>(1, min(threadCount, stepSamples));
+        const size_t shardSize = (stepSamples + workerCount - 1) / workerCount;
+        const size_t batchCols = max<size_t>(1, min(batchSize, shardSize));
+
+        ThreadPool pool(workerCount);
+        prepareWorkspaces(workerCount, batchCols);
+        optimizer.prepare(parameterSlotSizes());
+        vector<size_t> order;
+        if (miniBatches) {
+            order.resize(sampleTotal);
+        }
+
+        return runEpochs(valInputs, valTargets, epochs, verbose, [&](T rate) {
+            // Seeded from the epoch count, so a resumed run sees the same
+            // orders as an uninterrupted one.
+            if (miniBatches) {
+                iota(order.begin(), order.end(), size_t(0));
+                mt19937_64 rng(shuffleSeed + epochsTrained);
+                shuffle(order.begin(), order.end(), rng);
+            }
+
+            Accumulator totalLoss = Accumulator{};
+            for (size_t first = 0; first < sampleTotal; first += stepSamples) {
+                const size_t count = min(stepSamples, sampleTotal - first);
+                pool.parallelFor(workerCount, [&](size_t w) {
+                    const size_t begin = first + w * count / workerCount;
+                    const size_t end = first + (w + 1) * count / workerCount;
+                    trainShard(workspaces[w], trainInputs, trainTargets, order.empty() ? nullptr : order.data(), begin, end);
+                });
+                reduceWorkspaces(pool);
+
+                totalLoss += workspaces[0].loss;
+                applyGradients(workspaces[0], Accumulator(count), rate);
+            }
+            return make_pair(totalLoss, sampleTotal);
+        });
+    }
+
+    // Same loop over a DataStream, which packs the next batch on its own
+    // thread while this one trains. Each stream batch is split into worker
+    // shards like a step above. Mini-batch mode steps once per stream batch
+    // (the stream's window does the shuffling); full-batch mode sums every
+    // batch of the pass and steps once.
+    template<typename Samples>
+    int trainStream(DataStream<T>& stream, const Samples& valInputs, const Samples& valTargets, int epochs, bool verbose) {
+        if (stream.inputDim() != inputSize() || stream.outputDim() != outputSize()) {
+            throw invalid_argument("Stream samples do not match the network's layer sizes");
+        }
+        checkSamples(valInputs, valTargets);
+        const size_t streamRows = stream.getConfig().batchRows;
+        const size_t workerCount = max<size_t>(1, min(threadCount, streamRows));
+        const size_t shardSize = (streamRows + workerCount - 1) / workerCount;
+        const size_t batchCols = max<size_t>(1, min(batchSize, shardSize));
+
+        ThreadPool pool(workerCount);
+        prepareWorkspaces(workerCount, batchCols);
+        optimizer.prepare(parameterSlotSizes());
+
+        return runEpochs(valInputs, valTargets, epochs, verbose, [&](T rate) {
+            Accumulator totalLoss = Accumulator{};
+            size_t totalSamples = 0;
+            size_t pending = 0;
+            auto step = [&] {
+                reduceWorkspaces(pool);
+                totalLoss += workspaces[0].loss;
+                applyGradients(workspaces[0], Accumulator(pending), rate);
+                pending = 0;
+            };
+
+            stream.beginEpoch(epochsTrained);
+            while (true) {
+                const StreamBatch<T>* batch = nullptr;
+                {
+                    PROFILE_SCOPE(Load);
+                    batch = stream.next();
+                }
+                if (batch == nullptr) {
+                    break;
+                }
+                const MatrixView<const T> inputs = batch->inputView();
+                const MatrixView<const T> targets = batch->targetView();
+                const size_t count = batch->rows;
+                const bool accumulate = pending > 0;
+                pool.parallelFor(workerCount, [&](size_t w) {
+                    trainShard(workspaces[w], inputs, targets, nullptr, w * count / workerCount, (w + 1) * count / workerCount, accumulate);
+                });
+                totalSamples += count;
+                pending += count;
+                if (miniBatches) {
+                    step();
                 }
             }
+            if (pending > 0) {
+                step();
+            }
+            if (totalSamples == 0) {
+                throw runtime_error("Data stream produced no samples");
+            }
+            return make_pair(totalLoss, totalSamples);
+        });
+    }
+
+public:
+    // Uniform parameters from a fresh random seed, so every model differs.
+    MLP(vector<int> layers, T lr = T(0.01), size_t batch = 32) : MLP(layers, lr, batch, InitConfig{InitScheme::Uniform, randomSeed()}) {}
+
+    // Reproducible parameters: equal configs give bit-identical models.
+    MLP(vector<int> layers, T lr, size_t batch, const InitConfig& init) : MLP(layers, lr, batch, false) {
+        initializeParameters(init);
+    }
+
+private:
+    // randomize = false leaves the parameters zeroed for a caller that is
+    // about to overwrite them.
+    MLP(vector<int> layers, T lr, size_t batch, bool randomize) : layerSizes(layers), learningRate(lr), batchSize(batch), threadCount(1), sigmoidMode(blas::SigmoidMode::Exact) {
+        maxLayerWidth = size_t(*max_element(layers.begin(), layers.end()));
+
+        for (size_t i = 0; i < layers.size() - 1; ++i) {
+            weights.push_back(Matrix<T>(layers[i + 1], layers[i]));
+            biases.push_back(Matrix<T>(layers[i + 1], 1));
+        }
+        if (randomize) {
+            initializeParameters(InitConfig{InitScheme::Uniform, randomSeed()});
         }
-        
-        return totalLoss * (T(1.0) / T(testInputs.size()));
     }
 
-    T calculateAccuracy(vector<Matrix<T>> testInputs, vector<Matrix<T>> testTargets, T threshold = T(0.5)) {
-        T correct = T{};
-        
-        for (size_t sample = 0; sample < testInputs.size(); ++sample) {
-            Matrix<T> output = forward(testInputs[sample]);
-            bool allCorrect = true;
-            
-            for (size_t i = 0; i < output.getRows(); ++i) {
-                T predicted = output(i, 0) > threshold ? T(1.0) : T(0.0);
-                T target = testTargets[sample](i, 0);
-                if (abs(predicted - target) > T(0.1)) {
-                    allCorrect = false;
-                    break;
+public:
+    // Redraws every weight and bias from init. Parameters are filled in
+    // blocks on up to threadCount threads; a value depends only on the seed
+    // and its position, so the model is the same for any thread count.
+    // Pruned weights stay zero.
+    void initializeParameters(const InitConfig& init) {
+        constexpr size_t blockSize = size_t(1) << 16;
+        struct Block {
+            size_t layer;
+            bool bias;
+            size_t first;
+            size_t count;
+        };
+        vector<Block> blocks;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            for (bool bias : {false, true}) {
+                const size_t size = bias ? biases[i].size() : weights[i].size();
+                for (size_t first = 0; first < size; first += blockSize) {
+                    blocks.push_back({i, bias, first, min(blockSize, size - first)});
                 }
             }
-            
-            if (allCorrect) {
-                correct += T(1.0);
+        }
+
+        auto fillBlock = [&](size_t b) {
+            const Block& block = blocks[b];
+            Matrix<T>& target = block.bias ? biases[block.layer] : weights[block.layer];
+            initialParameters(init, block.layer, block.bias, weights[block.layer].getCols(), weights[block.layer].getRows(), block.first, block.count, target.getData() + block.first);
+        };
+        const size_t workers = min(threadCount, blocks.size());
+        if (workers > 1) {
+            ThreadPool pool(workers);
+            pool.parallelFor(blocks.size(), fillBlock);
+        } else {
+            for (size_t b = 0; b < blocks.size(); ++b) {
+                fillBlock(b);
             }
         }
-        
-        return correct * (T(1.0) / T(testInputs.size()));
+
+        for (size_t i = 0; i < weightMasks.size(); ++i) {
+            maskWeights(i);
+        }
+        resetEarlyStopping();
+        refreshSparseLayers();
+    }
+
+public:
+    size_t getBatchSize() const { return batchSize; }
+    void setBatchSize(size_t batch) { batchSize = batch > 0 ? batch : 1; }
+
+    // Training worker count; 0 selects one per hardware thread. Results are
+    // bit-identical across runs for the same count.
+    size_t getThreadCount() const { return threadCount; }
+    void setThreadCount(size_t threads) { threadCount = threads > 0 ? threads : max<size_t>(1, thread::hardware_concurrency()); }
+
+    // Exact keeps the activation at rounding-level error; Fast trades accuracy
+    // for a shorter polynomial (see blas::SigmoidMode for the error bounds).
+    blas::SigmoidMode getSigmoidMode() const { return sigmoidMode; }
+    void setSigmoidMode(blas::SigmoidMode mode) { sigmoidMode = mode; }
+
+    T getLearningRate() const { return learningRate; }
+    void setLearningRate(T lr) { learningRate = lr; }
+
+    // Update rule and learning-rate schedule; learningRate is the base rate.
+    // Changing it discards momentum and Adam state. That state is not part
+    // of checkpoints, so a resumed run restarts it from zero.
+    const OptimizerConfig& getOptimizer() const { return optimizer.getConfig(); }
+    void setOptimizer(const OptimizerConfig& config) { optimizer = Optimizer<T>(config); }
+
+    // false (the default) takes one full-batch step per epoch; true shuffles
+    // the training set every epoch and steps once per batchSize samples. The
+    // shuffle is seeded from seed and the epoch count.
+    bool getMiniBatches() const { return miniBatches; }
+    void setMiniBatches(bool enabled, uint64_t seed = 0) {
+        miniBatches = enabled;
+        shuffleSeed = seed;
+    }
+
+    const vector<int>& getLayerSizes() const { return layerSizes; }
+    const Matrix<T>& getWeights(size_t layer) const { return weights.at(layer); }
+    const Matrix<T>& getBiases(size_t layer) const { return biases.at(layer); }
+
+    // Replaces one layer's parameters; the shapes must match the layer's.
+    void setParameters(size_t layer, const Matrix<T>& w, const Matrix<T>& b) {
+        Matrix<T>& weight = weights.at(layer);
+        Matrix<T>& bias = biases.at(layer);
+        if (w.getRows() != weight.getRows() || w.getCols() != weight.getCols() || b.getRows() != bias.getRows() || b.getCols() != bias.getCols()) {
+            throw invalid_argument("Parameter shapes do not match the layer");
+        }
+        weight = w;
+        bias = b;
+        resetEarlyStopping();
+        refreshSparseLayers();
+    }
+
+    // Holds pruned weights at zero: masks[i] has layer i's weight shape, with
+    // 1 where the weight keeps training and 0 where it is pruned. Masked
+    // weights are zeroed now and after every optimizer step, so fine-tuning
+    // keeps the sparsity. Masks are not saved in checkpoints, but the zeros
+    // are.
+    void setWeightMasks(const vector<Matrix<T>>& masks) {
+        if (masks.size() != weights.size()) {
+            throw invalid_argument("Expected one weight mask per layer");
+        }
+        for (size_t i = 0; i < masks.size(); ++i) {
+            if (masks[i].getRows() != weights[i].getRows() || masks[i].getCols() != weights[i].getCols()) {
+                throw invalid_argument("Weight mask shape does not match the layer");
+            }
+        }
+        weightMasks = masks;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            maskWeights(i);
+        }
+        resetEarlyStopping();
+        refreshSparseLayers();
+    }
+
+    void clearWeightMasks() { weightMasks.clear(); }
+    bool hasWeightMasks() const { return !weightMasks.empty(); }
+    const Matrix<T>& getWeightMask(size_t layer) const { return weightMasks.at(layer); }
+
+    // Fraction of a layer's weights that are exactly zero.
+    double getWeightSparsity(size_t layer) const {
+        const Matrix<T>& w = weights.at(layer);
+        const size_t zeros = size_t(count(w.getData(), w.getData() + w.size(), T{}));
+        return w.size() == 0 ? 0.0 : double(zeros) / double(w.size());
+    }
+
+    // Layers at least this sparse are scored through a CSR copy and a
+    // sparse x dense kernel; above 1 every layer stays dense. The default is
+    // about where the sparse kernel starts beating the dense GEMM.
+    double getSparseThreshold() const { return sparseThreshold; }
+    void setSparseThreshold(double threshold) {
+        sparseThreshold = threshold;
+        refreshSparseLayers();
+    }
+
+    // True when inference runs this layer through the CSR kernel.
+    bool isSparseLayer(size_t layer) const { return isSparse(layer); }
+
+    // Bytes of weights as inference reads them: CSR values and indices for
+    // sparse layers, the dense matrix otherwise. Biases are not counted.
+    size_t weightBytes() const {
+        size_t bytes = 0;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            bytes += isSparse(i) ? sparseWeights[i].bytes() : weights[i].size() * sizeof(T);
+        }
+        return bytes;
+    }
+
+    // Epochs completed over the model's lifetime, carried through checkpoints
+    // so a resumed run can train only what is left.
+    uint64_t getEpochsTrained() const { return epochsTrained; }
+
+    // Saves a checkpoint to path every everyEpochs epochs and after the last
+    // epoch of each trainWithValidation call; 0 turns checkpointing off.
+    void setCheckpointing(const string& path, int everyEpochs) {
+        checkpointPath = path;
+        checkpointInterval = everyEpochs > 0 ? everyEpochs : 0;
+    }
+
+    void saveCheckpoint(const string& path) const {
+        vector<uint64_t> sizes(layerSizes.begin(), layerSizes.end());
+        vector<const T*> weightData, biasData;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            weightData.push_back(weights[i].getData());
+            biasData.push_back(biases[i].getData());
+        }
+        // The best parameters are only worth saving when a stop would put
+        // them back.
+        vector<const T*> bestWeightData, bestBiasData;
+        if (earlyStopping.restoreBest && bestLoss < numeric_limits<Accumulator>::infinity() && bestWeights.size() == weights.size()) {
+            for (size_t i = 0; i < weights.size(); ++i) {
+                bestWeightData.push_back(bestWeights[i].getData());
+                bestBiasData.push_back(bestBiases[i].getData());
+            }
+        }
+        const CheckpointStopping stopping{double(bestLoss), epochsSinceBest};
+        writeCheckpoint<T>(path, sizes, weightData, biasData, double(learningRate), batchSize, sigmoidMode, epochsTrained, stoppedEarly ? CHECKPOINT_STOPPED_EARLY : 0, stopping, bestWeightData, bestBiasData);
+    }
+
+    // Rebuilds a trainable model from a checkpoint: architecture,
+    // parameters, learning rate, batch size, sigmoid mode, epoch count and
+    // early-stopping progress (the stopping settings themselves are not
+    // saved).
+    // Momentum and Adam state, pruning masks and the optimizer, mini-batch
+    // and thread settings are not saved: the caller sets the settings again
+    // and optimizer state restarts from zero. A resume is bit-for-bit only
+    // for plain SGD with the same thread count and mini-batch seed (the
+    // shuffle follows from the seed and the epoch count).
+    static MLP loadCheckpoint(const string& path) {
+        MappedModel<T> model(path);
+        MLP result(vector<int>(model.getLayerSizes().begin(), model.getLayerSizes().end()), model.getLearningRate(), model.getBatchSize(), false);
+        result.setSigmoidMode(model.sigmoidMode());
+        result.epochsTrained = model.getEpochsTrained();
+        result.stoppedEarly = model.stoppedEarly();
+        result.bestLoss = Accumulator(model.stopping().bestLoss);
+        result.epochsSinceBest = model.stopping().epochsSinceBest;
+        for (size_t i = 0; i < result.weights.size(); ++i) {
+            copy(model.weights(i), model.weights(i) + result.weights[i].size(), result.weights[i].getData());
+            copy(model.biases(i), model.biases(i) + result.biases[i].size(), result.biases[i].getData());
+        }
+        if (model.hasBestParameters()) {
+            result.bestWeights = result.weights;
+            result.bestBiases = result.biases;
+            for (size_t i = 0; i < result.weights.size(); ++i) {
+                copy(model.bestWeights(i), model.bestWeights(i) + result.weights[i].size(), result.bestWeights[i].getData());
+                copy(model.bestBiases(i), model.bestBiases(i) + result.biases[i].size(), result.bestBiases[i].getData());
+            }
+        }
+        result.refreshSparseLayers();
+        return result;
+    }
+
+    // True when the last training call (or the run a checkpoint came from)
+    // was ended by early stopping.
+    bool getStoppedEarly() const { return stoppedEarly; }
+
+    const EarlyStopping& getEarlyStopping() const { return earlyStopping; }
+    void setEarlyStopping(const EarlyStopping& stopping) { earlyStopping = stopping; }
+
+    size_t inputSize() const { return size_t(layerSizes.front()); }
+    size_t outputSize() const { return size_t(layerSizes.back()); }
+
+    // Scores one sample: reads inputSize() features and writes outputSize()
+    // values. Layers alternate between two scratch rows of the widest layer's
+    // size and the last one writes straight into output.
+    void predict(const T* input, T* output) const {
+        inference::predict(weights.size(), maxLayerWidth, sigmoidMode, [this](size_t i) { return layer(i); }, input, output);
+    }
+
+    // Scores count samples stored row-major (count x inputSize()) into a
+    // count x outputSize() output, one GEMM per layer per block of rows.
+    // With sparse layers the blocks are packed as columns instead, the
+    // layout the CSR kernel runs on.
+    void predictBatch(const T* inputs, size_t count, T* outputs) const {
+        if (!hasSparseLayers()) {
+            inference::predictBatch(weights.size(), maxLayerWidth, sigmoidMode, [this](size_t i) { return layer(i); }, inputs, count, outputs);
+            return;
+        }
+
+        constexpr size_t blockRows = 64;
+        T* scratch = inference::scratch<T>(2 * blockRows * maxLayerWidth);
+        T* const buffers[2] = {scratch, scratch + blockRows * maxLayerWidth};
+        for (size_t first = 0; first < count; first += blockRows) {
+            const size_t rows = min(blockRows, count - first);
+            const T* in = inputs + first * inputSize();
+            for (size_t r = 0; r < rows; ++r) {
+                for (size_t k = 0; k < inputSize(); ++k) {
+                    buffers[0][k * blockRows + r] = in[r * inputSize() + k];
+                }
+            }
+            const T* result = forwardColumns(buffers, rows, blockRows);
+            T* out = outputs + first * outputSize();
+            for (size_t r = 0; r < rows; ++r) {
+                for (size_t j = 0; j < outputSize(); ++j) {
+                    out[r * outputSize() + j] = result[j * blockRows + r];
+                }
+            }
+        }
+    }
+
+    Matrix<T> forward(const Matrix<T>& input) const {
+        if (input.size() != inputSize()) {
+            throw invalid_argument("Input size does not match the network's input layer");
+        }
+        Matrix<T> output(outputSize(), 1);
+        predict(input.getData(), output.getData());
+        return output;
+    }
+
+    // Trains for up to epochs epochs and returns how many ran (see
+    // setEarlyStopping).
+    int trainWithValidation(const vector<Matrix<T>>& trainInputs, const vector<Matrix<T>>& trainTargets, const vector<Matrix<T>>& valInputs, const vector<Matrix<T>>& valTargets, int epochs, bool verbose = true) {
+        return train(trainInputs, trainTargets, valInputs, valTargets, epochs, verbose);
+    }
+
+    // Same training on samples stored one per row, e.g. the blocks of a
+    // mapped BinaryDataset; batches are packed straight from the views.
+    int trainWithValidation(MatrixView<const T> trainInputs, MatrixView<const T> trainTargets, MatrixView<const T> valInputs, MatrixView<const T> valTargets, int epochs, bool verbose = true) {
+        return train(trainInputs, trainTargets, valInputs, valTargets, epochs, verbose);
+    }
+
+    // Trains from a DataStream, so the training set never has to fit in
+    // memory and loading overlaps compute. The stream's batch size sets the
+    // step in mini-batch mode; validation data is held in memory as usual.
+    int trainWithValidation(DataStream<T>& stream, const vector<Matrix<T>>& valInputs, const vector<Matrix<T>>& valTargets, int epochs, bool verbose = true) {
+        return trainStream(stream, valInputs, valTargets, epochs, verbose);
+    }
+
+    int trainWithValidation(DataStream<T>& stream, MatrixView<const T> valInputs, MatrixView<const T> valTargets, int epochs, bool verbose = true) {
+        return trainStream(stream, valInputs, valTargets, epochs, verbose);
+    }
+
+    // Loss, exact-match accuracy and, with perOutput, per-output accuracy
+    // and confusion counts, all from one batched forward pass. Bit-identical
+    // for any thread count.
+    Metrics<T> computeMetrics(const vector<Matrix<T>>& inputs, const vector<Matrix<T>>& targets, bool perOutput = false, T threshold = T(0.5)) const {
+        return metricsPass(inputs, targets, perOutput, threshold);
+    }
+
+    Metrics<T> computeMetrics(MatrixView<const T> inputs, MatrixView<const T> targets, bool perOutput = false, T threshold = T(0.5)) const {
+        if (inputs.getCols() != inputSize() || targets.getCols() != outputSize()) {
+            throw invalid_argument("Sample views do not match the network's layer sizes");
+        }
+        return metricsPass(inputs, targets, perOutput, threshold);
+    }
+
+    T evaluate(const vector<Matrix<T>>& testInputs, const vector<Matrix<T>>& testTargets) const {
+        return computeMetrics(testInputs, testTargets).loss;
+    }
+
+    T calculateAccuracy(const vector<Matrix<T>>& testInputs, const vector<Matrix<T>>& testTargets, T threshold = T(0.5)) const {
+        return computeMetrics(testInputs, testTargets, false, threshold).accuracy;
     }
 };
 
@@ -0,0 +1,88 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+// Read-only view of a whole file: memory-mapped where available, otherwise
+// read into a buffer.
+class MappedFile {
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    explicit MappedFile(const string& path) {
+#ifdef _WIN32
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) {
+            throw runtime_error("Cannot open file " + path);
+        }
+        buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        ptr = buffer.data();
+        length = buffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open file " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw runtime_error("Cannot stat file " + path);
+        }
+        length = size_t(info.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map file " + path);
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            ptr = static_cast<const char*>(mapped);
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (ptr != nullptr) {
+            munmap(const_cast<char*>(ptr), length);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept : ptr(other.ptr), length(other.length) {
+#ifdef _WIN32
+        buffer = move(other.buffer);
+        ptr = buffer.data();
+#endif
+        other.ptr = nullptr;
+        other.length = 0;
+    }
+
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_H
@@ -1,150 +1,293 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <new>
 #include <vector>
 #include <random>
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 
+#include "Blas.h"
 #include "Complex.h"
+#include "Random.h"
+#include "Profiler.h"
 
 using namespace std;
 
+// Element and view bounds checks are only compiled in for checked builds
+// (make debug); release builds index straight into the buffer.
+#ifdef MATRIX_CHECKED
+#define MATRIX_CHECK_INDEX(condition) \
+    do { if (!(condition)) throw out_of_range("Matrix index out of bounds"); } while (0)
+#else
+#define MATRIX_CHECK_INDEX(condition) ((void)0)
+#endif
+
+// Cache-line alignment so every matrix starts on a SIMD-friendly boundary.
+constexpr size_t MATRIX_ALIGNMENT = 64;
+
+template<typename T, size_t Alignment = MATRIX_ALIGNMENT>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept {}
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n) {
+        PROFILE_ALLOCATION(n * sizeof(T));
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        ::operator delete(p, align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+// Non-owning strided window onto matrix storage. Rows, columns, sub-blocks and
+// transposes of a Matrix are all expressed as views without copying.
+template<typename T>
+class MatrixView {
+private:
+    T* ptr;
+    size_t rows, cols;
+    size_t rowStride, colStride;
+
+public:
+    MatrixView() : ptr(nullptr), rows(0), cols(0), rowStride(0), colStride(0) {}
+
+    MatrixView(T* p, size_t r, size_t c, size_t rs, size_t cs = 1) : ptr(p), rows(r), cols(c), rowStride(rs), colStride(cs) {}
+
+    template<typename U, typename = enable_if_t<is_convertible<U*, T*>::value>>
+    MatrixView(const MatrixView<U>& other) : ptr(other.getData()), rows(other.getRows()), cols(other.getCols()), rowStride(other.getRowStride()), colStride(other.getColStride()) {}
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getRowStride() const { return rowStride; }
+    size_t getColStride() const { return colStride; }
+    T* getData() const { return ptr; }
+
+    bool isContiguous() const {
+        return colStride == 1 && (rowStride == cols || rows <= 1);
+    }
+
+    T& operator()(size_t row, size_t col) const {
+        MATRIX_CHECK_INDEX(row < rows && col < cols);
+        return ptr[row * rowStride + col * colStride];
+    }
+
+    MatrixView row(size_t r) const {
+        MATRIX_CHECK_INDEX(r < rows);
+        return MatrixView(ptr + r * rowStride, 1, cols, rowStride, colStride);
+    }
+
+    MatrixView col(size_t c) const {
+        MATRIX_CHECK_INDEX(c < cols);
+        return MatrixView(ptr + c * colStride, rows, 1, rowStride, colStride);
+    }
+
+    MatrixView block(size_t firstRow, size_t firstCol, size_t numRows, size_t numCols) const {
+        MATRIX_CHECK_INDEX(firstRow + numRows <= rows && firstCol + numCols <= cols);
+        return MatrixView(ptr + firstRow * rowStride + firstCol * colStride, numRows, numCols, rowStride, colStride);
+    }
+
+    MatrixView transposed() const {
+        return MatrixView(ptr, cols, rows, colStride, rowStride);
+    }
+};
+
+// Dense row-major matrix backed by a single aligned contiguous buffer.
 template<typename T>
 class Matrix {
 private:
-    vector<vector<T>> data;
+    vector<T, AlignedAllocator<T>> data;
     size_t rows, cols;
 
 public:
     Matrix() : rows(0), cols(0) {}
-    
-    Matrix(size_t r, size_t c) : rows(r), cols(c) {
-        data.resize(rows, vector<T>(cols, T{}));
+
+    Matrix(size_t r, size_t c) : data(r * c, T{}), rows(r), cols(c) {}
+
+    Matrix(vector<vector<T>> input) {
+        rows = input.size();
+        cols = rows > 0 ? input[0].size() : 0;
+        data.reserve(rows * cols);
+        for (size_t i = 0; i < rows; ++i) {
+            if (input[i].size() != cols) {
+                throw invalid_argument("All matrix rows must have the same length");
+            }
+            data.insert(data.end(), input[i].begin(), input[i].end());
+        }
     }
 
-    Matrix(vector<vector<T>> input) : data(input) {
-        rows = data.size();
-        cols = rows > 0 ? data[0].size() : 0;
+    Matrix(vector<T> vec, bool column = true) : data(vec.begin(), vec.end()) {
+        rows = column ? vec.size() : 1;
+        cols = column ? 1 : vec.size();
     }
 
-    Matrix(vector<T> vec, bool column = true) {
-        if (column) {
-            rows = vec.size();
-            cols = 1;
-            data.resize(rows, vector<T>(1));
-            for (size_t i = 0; i < rows; ++i) {
-                data[i][0] = vec[i];
+    explicit Matrix(MatrixView<const T> source) : data(source.getRows() * source.getCols()), rows(source.getRows()), cols(source.getCols()) {
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                data[i * cols + j] = source(i, j);
             }
-        } else {
-            rows = 1;
-            cols = vec.size();
-            data.resize(1, vec);
         }
     }
 
     size_t getRows() const { return rows; }
     size_t getCols() const { return cols; }
+    size_t size() const { return data.size(); }
 
-    T operator()(size_t row, size_t col) {
-        if (row >= rows || col >= cols) {
-            throw out_of_range("Matrix index out of bounds");
-        }
-        return data[row][col];
+    T* getData() { return data.data(); }
+    const T* getData() const { return data.data(); }
+
+    T& operator()(size_t row, size_t col) {
+        MATRIX_CHECK_INDEX(row < rows && col < cols);
+        return data[row * cols + col];
+    }
+
+    const T& operator()(size_t row, size_t col) const {
+        MATRIX_CHECK_INDEX(row < rows && col < cols);
+        return data[row * cols + col];
     }
 
     void set(size_t row, size_t col, T value) {
-        if (row >= rows || col >= cols) {
-            throw out_of_range("Matrix index out of bounds");
-        }
+        MATRIX_CHECK_INDEX(row < rows && col < cols);
+        data[row * cols + col] = value;
+    }
 
-        data[row][col] = value;
+    void fill(T value) {
+        std::fill(data.begin(), data.end(), value);
     }
 
-    Matrix operator+(Matrix other) const {
+    MatrixView<T> view() { return MatrixView<T>(data.data(), rows, cols, cols); }
+    MatrixView<const T> view() const { return MatrixView<const T>(data.data(), rows, cols, cols); }
+
+    MatrixView<T> row(size_t r) { return view().row(r); }
+    MatrixView<const T> row(size_t r) const { return view().row(r); }
+
+    MatrixView<T> col(size_t c) { return view().col(c); }
+    MatrixView<const T> col(size_t c) const { return view().col(c); }
+
+    MatrixView<T> block(size_t firstRow, size_t firstCol, size_t numRows, size_t numCols) {
+        return view().block(firstRow, firstCol, numRows, numCols);
+    }
+
+    MatrixView<const T> block(size_t firstRow, size_t firstCol, size_t numRows, size_t numCols) const {
+        return view().block(firstRow, firstCol, numRows, numCols);
+    }
+
+    // Reshapes in place, keeping the existing allocation whenever it is large
+    // enough. Contents are unspecified afterwards.
+    void resize(size_t r, size_t c) {
+        data.resize(r * c);
+        rows = r;
+        cols = c;
+    }
+
+    Matrix& operator+=(const Matrix& other) {
         if (rows != other.rows || cols != other.cols) {
             throw invalid_argument("Matrix dimensions must match for addition");
         }
-
-        Matrix result(rows, cols);
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result.set(i, j, data[i][j] + other(i, j));
-            }
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] += other.data[i];
         }
-        return result;
+        return *this;
     }
 
-    Matrix operator-(Matrix other) const {
+    Matrix& operator-=(const Matrix& other) {
         if (rows != other.rows || cols != other.cols) {
             throw invalid_argument("Matrix dimensions must match for subtraction");
         }
-        Matrix result(rows, cols);
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result.set(i, j, data[i][j] - other(i, j));
-            }
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] -= other.data[i];
+        }
+        return *this;
+    }
+
+    Matrix& operator*=(T scalar) {
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] *= scalar;
         }
+        return *this;
+    }
+
+    Matrix operator+(const Matrix& other) const {
+        Matrix result(*this);
+        result += other;
+        return result;
+    }
+
+    Matrix operator-(const Matrix& other) const {
+        Matrix result(*this);
+        result -= other;
         return result;
     }
 
-    Matrix operator*(Matrix other) const {
+    // result = this * other without allocating; result must already have
+    // getRows() x other.getCols() elements and must not alias either operand.
+    void multiplyInto(const Matrix& other, Matrix& result) const {
+        if (cols != other.rows || result.rows != rows || result.cols != other.cols) {
+            throw invalid_argument("Invalid matrix dimensions for multiplication");
+        }
+        if (other.cols == 1) {
+            blas::gemv(rows, cols, data.data(), cols, other.data.data(), result.data.data());
+        } else {
+            blas::gemm(rows, other.cols, cols, data.data(), cols, other.data.data(), other.cols, result.data.data(), other.cols);
+        }
+    }
+
+    Matrix operator*(const Matrix& other) const {
         if (cols != other.rows) {
             throw invalid_argument("Invalid matrix dimensions for multiplication");
         }
         Matrix result(rows, other.cols);
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < other.cols; ++j) {
-                T sum = T{};
-                for (size_t k = 0; k < cols; ++k) {
-                    sum += data[i][k] * other(k, j);
-                }
-                result.set(i, j, sum);
-            }
-        }
+        multiplyInto(other, result);
         return result;
     }
 
     Matrix operator*(T scalar) const {
-        Matrix result(rows, cols);
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result.set(i, j, data[i][j] * scalar);
-            }
-        }
+        Matrix result(*this);
+        result *= scalar;
         return result;
     }
 
+    // Uniform values from a fresh random_device seed: different every call.
     void randomize(T minVal = T{-1}, T maxVal = T{1}) {
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_real_distribution<double> dis{double(minVal), double(maxVal)};
-        
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                data[i][j] = T(dis(gen));
-            }
-        }
+        randomize(minVal, maxVal, randomSeed());
+    }
+
+    // Reproducible uniform values: element i is value i of the given Philox
+    // stream, so equal seeds and streams give equal matrices.
+    void randomize(T minVal, T maxVal, uint64_t seed, uint64_t stream = 0) {
+        philoxUniform(seed, stream, 0, data.size(), minVal, maxVal, data.data());
     }
 
     vector<T> toVector() const {
-        vector<T> result;
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result.push_back(data[i][j]);
-            }
-        }
-        return result;
+        return vector<T>(data.begin(), data.end());
     }
 
     void print() const {
         for (size_t i = 0; i < rows; ++i) {
             for (size_t j = 0; j < cols; ++j) {
-                cout << data[i][j] << " ";
+                cout << data[i * cols + j] << " ";
             }
             cout << endl;
         }
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,109 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Counts for one output treated as a binary classifier: predicted positive
+// when the output is above the threshold, actually positive when the target
+// is above 0.5.
+struct OutputConfusion {
+    uint64_t truePositive = 0;
+    uint64_t falsePositive = 0;
+    uint64_t trueNegative = 0;
+    uint64_t falseNegative = 0;
+};
+
+// Everything one evaluation pass over a dataset reports. loss is the mean
+// over samples of the summed squared error; a sample is accurate when every
+// thresholded output is within 0.1 of its target. outputAccuracy and
+// confusion hold one entry per output and are only filled when requested.
+template<typename T>
+struct Metrics {
+    size_t samples = 0;
+    T loss = T{};
+    T accuracy = T{};
+    vector<T> outputAccuracy;
+    vector<OutputConfusion> confusion;
+};
+
+// Running sums over blocks of predictions. Sums stay in the accumulator type
+// A; merging per-block totals in block order gives the same result however
+// the blocks were spread over threads.
+template<typename T, typename A>
+class MetricTotals {
+private:
+    A squaredError = A{};
+    uint64_t samples = 0;
+    uint64_t correct = 0;
+    vector<uint64_t> outputCorrect;
+    vector<OutputConfusion> confusion;
+
+public:
+    MetricTotals() = default;
+    MetricTotals(size_t outputs, bool perOutput) : outputCorrect(perOutput ? outputs : 0), confusion(perOutput ? outputs : 0) {}
+
+    // Scores count samples stored as columns: output i of sample b is
+    // outputs[i * ld + b], and likewise for targets.
+    void add(const T* outputs, const T* targets, size_t count, size_t width, size_t ld, T threshold) {
+        const bool perOutput = !confusion.empty();
+        for (size_t b = 0; b < count; ++b) {
+            bool allCorrect = true;
+            for (size_t i = 0; i < width; ++i) {
+                const T output = outputs[i * ld + b];
+                const T target = targets[i * ld + b];
+                const T error = output - target;
+                squaredError += A(error) * A(error);
+
+                const bool predictedPositive = output > threshold;
+                const bool matches = abs((predictedPositive ? T(1.0) : T(0.0)) - target) <= T(0.1);
+                allCorrect = allCorrect && matches;
+                if (perOutput) {
+                    outputCorrect[i] += matches ? 1 : 0;
+                    OutputConfusion& counts = confusion[i];
+                    if (target > T(0.5)) {
+                        ++(predictedPositive ? counts.truePositive : counts.falseNegative);
+                    } else {
+                        ++(predictedPositive ? counts.falsePositive : counts.trueNegative);
+                    }
+                }
+            }
+            correct += allCorrect ? 1 : 0;
+        }
+        samples += count;
+    }
+
+    void merge(const MetricTotals& other) {
+        squaredError += other.squaredError;
+        samples += other.samples;
+        correct += other.correct;
+        for (size_t i = 0; i < outputCorrect.size(); ++i) {
+            outputCorrect[i] += other.outputCorrect[i];
+            confusion[i].truePositive += other.confusion[i].truePositive;
+            confusion[i].falsePositive += other.confusion[i].falsePositive;
+            confusion[i].trueNegative += other.confusion[i].trueNegative;
+            confusion[i].falseNegative += other.confusion[i].falseNegative;
+        }
+    }
+
+    Metrics<T> finish() const {
+        Metrics<T> metrics;
+        metrics.samples = size_t(samples);
+        metrics.confusion = confusion;
+        if (samples == 0) {
+            return metrics;
+        }
+        const A perSample = A(1.0) / A(samples);
+        metrics.loss = T(squaredError * perSample);
+        metrics.accuracy = T(A(correct) * perSample);
+        for (uint64_t count : outputCorrect) {
+            metrics.outputAccuracy.push_back(T(A(count) * perSample));
+        }
+        return metrics;
+    }
+};
+
+#endif // METRICS_H
@@ -0,0 +1,148 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Update rules for MLP training. Every rule sees the mean gradient g of one
+// update step (one epoch in full-batch mode, one mini-batch otherwise):
+//   SGD       w -= lr * g
+//   Momentum  v = mu * v + g;  w -= lr * v
+//   Nesterov  v = mu * v + g;  w -= lr * (g + mu * v)
+//   Adam      m, v moving averages of g and g^2 with bias correction;
+//             w -= lr * m^ / (sqrt(v^) + epsilon)
+enum class OptimizerKind { SGD, Momentum, Nesterov, Adam };
+
+// Learning rate as a function of the model's epoch count e:
+//   Constant     lr
+//   Step         lr * decay^(e / decayEpochs)
+//   Exponential  lr * decay^e
+//   Cosine       anneals from lr to lr * minScale over decayEpochs epochs,
+//                then stays there
+enum class LearningRateSchedule { Constant, Step, Exponential, Cosine };
+
+struct OptimizerConfig {
+    OptimizerKind kind = OptimizerKind::SGD;
+    double momentum = 0.9;
+    double beta1 = 0.9;
+    double beta2 = 0.999;
+    double epsilon = 1e-8;
+    LearningRateSchedule schedule = LearningRateSchedule::Constant;
+    double decay = 0.5;
+    int decayEpochs = 1000;
+    double minScale = 0.0;
+};
+
+inline const char* optimizerName(OptimizerKind kind) {
+    switch (kind) {
+        case OptimizerKind::Momentum: return "momentum";
+        case OptimizerKind::Nesterov: return "nesterov";
+        case OptimizerKind::Adam: return "adam";
+        default: return "sgd";
+    }
+}
+
+inline double scheduledRate(const OptimizerConfig& config, double baseRate, uint64_t epoch) {
+    switch (config.schedule) {
+        case LearningRateSchedule::Step:
+            return baseRate * pow(config.decay, double(epoch / uint64_t(max(1, config.decayEpochs))));
+        case LearningRateSchedule::Exponential:
+            return baseRate * pow(config.decay, double(epoch));
+        case LearningRateSchedule::Cosine: {
+            const double progress = min(1.0, double(epoch) / double(max(1, config.decayEpochs)));
+            return baseRate * (config.minScale + (1.0 - config.minScale) * 0.5 * (1.0 + cos(M_PI * progress)));
+        }
+        default:
+            return baseRate;
+    }
+}
+
+// Per-parameter optimizer state for one model. Parameter tensors are
+// registered as numbered slots; step() updates one slot in place from its
+// summed gradient. Slots keep their state across training calls, so
+// repeated trainWithValidation calls continue the same trajectory.
+template<typename T>
+class Optimizer {
+private:
+    OptimizerConfig config;
+    vector<vector<T>> first;
+    vector<vector<T>> second;
+    uint64_t steps = 0;
+
+public:
+    Optimizer() = default;
+    explicit Optimizer(const OptimizerConfig& c) : config(c) {}
+
+    const OptimizerConfig& getConfig() const { return config; }
+
+    // Sizes the state for slots of the given element counts, zeroing it when
+    // the shapes change. Plain SGD keeps no state.
+    void prepare(const vector<size_t>& slotSizes) {
+        const bool needsFirst = config.kind != OptimizerKind::SGD;
+        const bool needsSecond = config.kind == OptimizerKind::Adam;
+        bool matches = first.size() == (needsFirst ? slotSizes.size() : 0) && second.size() == (needsSecond ? slotSizes.size() : 0);
+        for (size_t s = 0; matches && needsFirst && s < slotSizes.size(); ++s) {
+            matches = first[s].size() == slotSizes[s];
+        }
+        if (matches) {
+            return;
+        }
+        first.clear();
+        second.clear();
+        steps = 0;
+        for (size_t size : slotSizes) {
+            if (needsFirst) first.push_back(vector<T>(size, T{}));
+            if (needsSecond) second.push_back(vector<T>(size, T{}));
+        }
+    }
+
+    // Starts an update step; Adam's bias correction counts these.
+    void beginStep() { ++steps; }
+
+    // params[i] -= update(gradients[i] * gradientScale) for one slot.
+    // gradientScale turns summed gradients into a mean; G may be wider than T.
+    template<typename G>
+    void step(size_t slot, T* params, const G* gradients, size_t count, G gradientScale, T rate) {
+        switch (config.kind) {
+            case OptimizerKind::Momentum:
+            case OptimizerKind::Nesterov: {
+                const T mu = T(config.momentum);
+                const bool nesterov = config.kind == OptimizerKind::Nesterov;
+                T* velocity = first[slot].data();
+                for (size_t i = 0; i < count; ++i) {
+                    const T g = T(gradients[i] * gradientScale);
+                    velocity[i] = mu * velocity[i] + g;
+                    params[i] -= rate * (nesterov ? g + mu * velocity[i] : velocity[i]);
+                }
+                return;
+            }
+            case OptimizerKind::Adam: {
+                const T beta1 = T(config.beta1);
+                const T beta2 = T(config.beta2);
+                const T epsilon = T(config.epsilon);
+                const T correction1 = T(1.0 / (1.0 - pow(config.beta1, double(steps))));
+                const T correction2 = T(1.0 / (1.0 - pow(config.beta2, double(steps))));
+                T* mean = first[slot].data();
+                T* variance = second[slot].data();
+                for (size_t i = 0; i < count; ++i) {
+                    const T g = T(gradients[i] * gradientScale);
+                    mean[i] = beta1 * mean[i] + (T(1.0) - beta1) * g;
+                    variance[i] = beta2 * variance[i] + (T(1.0) - beta2) * g * g;
+                    params[i] -= rate * (mean[i] * correction1) / (sqrt(variance[i] * correction2) + epsilon);
+                }
+                return;
+            }
+            default:
+                for (size_t i = 0; i < count; ++i) {
+                    const T g = T(gradients[i] * gradientScale);
+                    params[i] = params[i] - rate * g;
+                }
+                return;
+        }
+    }
+};
+
+#endif // OPTIMIZER_H
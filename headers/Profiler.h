@@ -0,0 +1,263 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Training-loop instrumentation. Builds with -DMLP_PROFILE (make profile) get
+// per-phase scoped timers, per-layer FLOP/byte counters and Matrix allocation
+// counts; every other build compiles each PROFILE_* macro to nothing.
+//
+// At run time, with profiling compiled in:
+//   MLP_PROFILE_JSON=file   appends one JSON summary line per training epoch
+//   MLP_PROFILE_TRACE=file  writes a Chrome trace (chrome://tracing, Perfetto)
+//                           of every timed scope when the program exits
+#ifdef MLP_PROFILE
+
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+
+using namespace std;
+
+namespace profiling {
+
+enum class Phase { Pack, Forward, Backward, Gradients, Reduce, Update, Validation, Checkpoint, Load, Count };
+
+constexpr size_t phaseCount = size_t(Phase::Count);
+
+// Layers past this share the last counter slot.
+constexpr size_t maxLayers = 16;
+
+// The trace stops recording scopes after this many, so a long run cannot
+// exhaust memory; the epoch events are always kept.
+constexpr size_t maxTraceEvents = 1 << 20;
+
+inline const char* phaseName(Phase phase) {
+    static const char* const names[phaseCount] = {"pack", "forward", "backward", "gradients", "reduce", "update", "validation", "checkpoint", "load"};
+    return names[size_t(phase)];
+}
+
+// Counters are relaxed atomics so training workers can bump them without
+// locking; phase times are summed over threads, so with several workers they
+// can exceed wall-clock time.
+class Profiler {
+private:
+    using Clock = chrono::steady_clock;
+
+    struct TraceEvent {
+        const char* name;
+        uint64_t startNs;
+        uint64_t durationNs;
+        uint32_t thread;
+        uint64_t epoch;
+        bool epochSpan;
+    };
+
+    struct Snapshot {
+        array<uint64_t, phaseCount> phaseNanos{};
+        array<uint64_t, phaseCount> phaseCalls{};
+        array<uint64_t, maxLayers> layerFlops{};
+        array<uint64_t, maxLayers> layerBytes{};
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+    };
+
+    array<atomic<uint64_t>, phaseCount> phaseNanos{};
+    array<atomic<uint64_t>, phaseCount> phaseCalls{};
+    array<atomic<uint64_t>, maxLayers> layerFlops{};
+    array<atomic<uint64_t>, maxLayers> layerBytes{};
+    atomic<uint64_t> allocations{0};
+    atomic<uint64_t> allocatedBytes{0};
+    atomic<uint32_t> nextThreadId{0};
+
+    const Clock::time_point origin = Clock::now();
+
+    mutex epochLock;
+    Snapshot lastEpoch;
+    uint64_t lastEpochNs = 0;
+    ofstream jsonLines;
+
+    mutex traceLock;
+    atomic<bool> tracing{false};
+    string tracePath;
+    vector<TraceEvent> events;
+    size_t droppedEvents = 0;
+
+    Profiler() {
+        if (const char* path = getenv("MLP_PROFILE_JSON")) {
+            jsonLines.open(path, ios::app);
+        }
+        if (const char* path = getenv("MLP_PROFILE_TRACE")) {
+            tracePath = path;
+            tracing = true;
+        }
+    }
+
+    ~Profiler() { writeTrace(); }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (size_t p = 0; p < phaseCount; ++p) {
+            s.phaseNanos[p] = phaseNanos[p].load(memory_order_relaxed);
+            s.phaseCalls[p] = phaseCalls[p].load(memory_order_relaxed);
+        }
+        for (size_t l = 0; l < maxLayers; ++l) {
+            s.layerFlops[l] = layerFlops[l].load(memory_order_relaxed);
+            s.layerBytes[l] = layerBytes[l].load(memory_order_relaxed);
+        }
+        s.allocations = allocations.load(memory_order_relaxed);
+        s.allocatedBytes = allocatedBytes.load(memory_order_relaxed);
+        return s;
+    }
+
+    uint32_t currentThreadId() {
+        static thread_local uint32_t id = nextThreadId++;
+        return id;
+    }
+
+    void addEvent(const char* name, uint64_t startNs, uint64_t durationNs, uint64_t epoch, bool always) {
+        lock_guard<mutex> guard(traceLock);
+        if (!always && events.size() >= maxTraceEvents) {
+            ++droppedEvents;
+            return;
+        }
+        events.push_back({name, startNs, durationNs, currentThreadId(), epoch, always});
+    }
+
+public:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    uint64_t nowNs() const {
+        return uint64_t(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - origin).count());
+    }
+
+    void record(Phase phase, uint64_t startNs, uint64_t endNs) {
+        phaseNanos[size_t(phase)].fetch_add(endNs - startNs, memory_order_relaxed);
+        phaseCalls[size_t(phase)].fetch_add(1, memory_order_relaxed);
+        if (tracing) {
+            addEvent(phaseName(phase), startNs, endNs - startNs, 0, false);
+        }
+    }
+
+    void countLayer(size_t layer, uint64_t flops, uint64_t bytes) {
+        layer = min(layer, maxLayers - 1);
+        layerFlops[layer].fetch_add(flops, memory_order_relaxed);
+        layerBytes[layer].fetch_add(bytes, memory_order_relaxed);
+    }
+
+    void countAllocation(uint64_t bytes) {
+        allocations.fetch_add(1, memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes, memory_order_relaxed);
+    }
+
+    // Closes an epoch: writes the counters accumulated since the previous
+    // epoch as one JSON line and adds an epoch span to the trace.
+    void endEpoch(uint64_t epoch, size_t samples, size_t layerCount) {
+        lock_guard<mutex> guard(epochLock);
+        const uint64_t now = nowNs();
+        const Snapshot current = snapshot();
+        const double seconds = double(now - lastEpochNs) * 1e-9;
+
+        if (jsonLines.is_open()) {
+            char number[64];
+            string line = "{\"epoch\":" + to_string(epoch) + ",\"samples\":" + to_string(samples);
+            snprintf(number, sizeof(number), "%.6f", seconds * 1e3);
+            line += string(",\"wall_ms\":") + number + ",\"phases\":{";
+            for (size_t p = 0; p < phaseCount; ++p) {
+                snprintf(number, sizeof(number), "%.6f", double(current.phaseNanos[p] - lastEpoch.phaseNanos[p]) * 1e-6);
+                line += string(p > 0 ? "," : "") + "\"" + phaseName(Phase(p)) + "\":{\"ms\":" + number + ",\"calls\":" + to_string(current.phaseCalls[p] - lastEpoch.phaseCalls[p]) + "}";
+            }
+            line += "},\"layers\":[";
+            uint64_t totalFlops = 0;
+            for (size_t l = 0; l < min(layerCount, maxLayers); ++l) {
+                const uint64_t flops = current.layerFlops[l] - lastEpoch.layerFlops[l];
+                totalFlops += flops;
+                line += string(l > 0 ? "," : "") + "{\"flops\":" + to_string(flops) + ",\"bytes\":" + to_string(current.layerBytes[l] - lastEpoch.layerBytes[l]) + "}";
+            }
+            snprintf(number, sizeof(number), "%.4f", seconds > 0.0 ? double(totalFlops) / seconds * 1e-9 : 0.0);
+            line += string("],\"gflops\":") + number + ",\"allocations\":" + to_string(current.allocations - lastEpoch.allocations) + ",\"allocated_bytes\":" + to_string(current.allocatedBytes - lastEpoch.allocatedBytes) + "}\n";
+            jsonLines << line << flush;
+        }
+        if (tracing) {
+            addEvent("epoch", lastEpochNs, now - lastEpochNs, epoch, true);
+        }
+
+        lastEpoch = current;
+        lastEpochNs = now;
+    }
+
+    // Marks the start of a training run so its first epoch is not charged
+    // with whatever ran before it.
+    void beginTraining() {
+        lock_guard<mutex> guard(epochLock);
+        lastEpoch = snapshot();
+        lastEpochNs = nowNs();
+    }
+
+    void writeTrace() {
+        lock_guard<mutex> guard(traceLock);
+        if (!tracing) {
+            return;
+        }
+        ofstream file(tracePath);
+        file << "{\"traceEvents\":[\n";
+        char line[256];
+        for (size_t i = 0; i < events.size(); ++i) {
+            // Epoch spans get their own track (tid 0) above the worker threads.
+            const TraceEvent& e = events[i];
+            const string name = e.epochSpan ? "epoch " + to_string(e.epoch) : string(e.name);
+            snprintf(line, sizeof(line), "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}%s\n",
+                     name.c_str(), e.epochSpan ? "epoch" : "phase", double(e.startNs) * 1e-3, double(e.durationNs) * 1e-3,
+                     e.epochSpan ? 0u : e.thread + 1, i + 1 < events.size() ? "," : "");
+            file << line;
+        }
+        file << "],\"otherData\":{\"dropped_events\":" << droppedEvents << "}}" << endl;
+        tracing = false;
+    }
+};
+
+class ScopedTimer {
+private:
+    Phase phase;
+    uint64_t start;
+
+public:
+    explicit ScopedTimer(Phase timedPhase) : phase(timedPhase), start(Profiler::instance().nowNs()) {}
+    ~ScopedTimer() { Profiler::instance().record(phase, start, Profiler::instance().nowNs()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+} // namespace profiling
+
+#define PROFILE_JOIN_NAME(a, b) a##b
+#define PROFILE_SCOPE_NAME(line) PROFILE_JOIN_NAME(profileScope, line)
+#define PROFILE_SCOPE(phase) profiling::ScopedTimer PROFILE_SCOPE_NAME(__LINE__)(profiling::Phase::phase)
+#define PROFILE_LAYER(layer, flops, bytes) profiling::Profiler::instance().countLayer((layer), uint64_t(flops), uint64_t(bytes))
+#define PROFILE_ALLOCATION(bytes) profiling::Profiler::instance().countAllocation(uint64_t(bytes))
+#define PROFILE_BEGIN_TRAINING() profiling::Profiler::instance().beginTraining()
+#define PROFILE_EPOCH(epoch, samples, layerCount) profiling::Profiler::instance().endEpoch((epoch), (samples), (layerCount))
+
+#else
+
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_LAYER(layer, flops, bytes) ((void)0)
+#define PROFILE_ALLOCATION(bytes) ((void)0)
+#define PROFILE_BEGIN_TRAINING() ((void)0)
+#define PROFILE_EPOCH(epoch, samples, layerCount) ((void)0)
+
+#endif // MLP_PROFILE
+
+#endif // PROFILER_H
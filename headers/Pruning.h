@@ -0,0 +1,97 @@
+#ifndef PRUNING_H
+#define PRUNING_H
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "MLP.h"
+
+using namespace std;
+
+// Magnitude pruning for a trained MLP: the smallest weights by absolute
+// value are set to zero and masked, so optional fine-tuning keeps them
+// there. Biases are never pruned. Once a layer is sparse enough (see
+// MLP::setSparseThreshold) inference switches it to the CSR kernel.
+struct PruningConfig {
+    // Fraction of weights to remove. Global mode ranks the weights of all
+    // layers together, so layers with many small weights lose more of them;
+    // otherwise every layer loses the same fraction.
+    double sparsity = 0.5;
+    bool global = true;
+    // Per-layer fractions; when given they replace sparsity and global.
+    vector<double> layerSparsity;
+    // Epochs of training after pruning, with the mask held.
+    int fineTuneEpochs = 0;
+};
+
+// Keep-masks for config without touching the model. Ties in magnitude go to
+// the lower layer and index, so the masks are deterministic.
+template<typename T>
+vector<Matrix<T>> magnitudeMasks(const MLP<T>& model, const PruningConfig& config) {
+    const size_t layers = model.getLayerSizes().size() - 1;
+    if (!config.layerSparsity.empty() && config.layerSparsity.size() != layers) {
+        throw invalid_argument("Expected one sparsity per layer");
+    }
+
+    vector<Matrix<T>> masks;
+    for (size_t i = 0; i < layers; ++i) {
+        const Matrix<T>& w = model.getWeights(i);
+        masks.push_back(Matrix<T>(w.getRows(), w.getCols()));
+        masks.back().fill(T(1.0));
+    }
+
+    // Magnitude, then (layer, index), of every weight in a group of layers;
+    // the smallest fraction of the group is pruned.
+    auto pruneGroup = [&](size_t firstLayer, size_t endLayer, double fraction) {
+        vector<pair<T, pair<size_t, size_t>>> ranked;
+        for (size_t i = firstLayer; i < endLayer; ++i) {
+            const Matrix<T>& w = model.getWeights(i);
+            for (size_t k = 0; k < w.size(); ++k) {
+                ranked.push_back({T(fabs(w.getData()[k])), {i, k}});
+            }
+        }
+        const size_t pruned = min(ranked.size(), size_t(llround(min(max(fraction, 0.0), 1.0) * double(ranked.size()))));
+        if (pruned == 0) {
+            return;
+        }
+        nth_element(ranked.begin(), ranked.begin() + long(pruned - 1), ranked.end());
+        for (size_t p = 0; p < pruned; ++p) {
+            masks[ranked[p].second.first].getData()[ranked[p].second.second] = T{};
+        }
+    };
+
+    if (!config.layerSparsity.empty()) {
+        for (size_t i = 0; i < layers; ++i) {
+            pruneGroup(i, i + 1, config.layerSparsity[i]);
+        }
+    } else if (config.global) {
+        pruneGroup(0, layers, config.sparsity);
+    } else {
+        for (size_t i = 0; i < layers; ++i) {
+            pruneGroup(i, i + 1, config.sparsity);
+        }
+    }
+    return masks;
+}
+
+// Prunes model in place and installs the masks.
+template<typename T>
+void pruneByMagnitude(MLP<T>& model, const PruningConfig& config) {
+    model.setWeightMasks(magnitudeMasks(model, config));
+}
+
+// Prunes, then fine-tunes for config.fineTuneEpochs with the mask held;
+// returns the fine-tuning epochs run (early stopping applies as usual).
+template<typename T, typename Samples>
+int pruneAndFineTune(MLP<T>& model, const PruningConfig& config, const Samples& trainInputs, const Samples& trainTargets, const Samples& valInputs, const Samples& valTargets, bool verbose = false) {
+    pruneByMagnitude(model, config);
+    if (config.fineTuneEpochs <= 0) {
+        return 0;
+    }
+    return model.trainWithValidation(trainInputs, trainTargets, valInputs, valTargets, config.fineTuneEpochs, verbose);
+}
+
+#endif // PRUNING_H
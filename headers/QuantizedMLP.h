@@ -0,0 +1,277 @@
+#ifndef QUANTIZED_MLP_H
+#define QUANTIZED_MLP_H
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "MLP.h"
+#include "BlasInt8.h"
+
+using namespace std;
+
+// Post-training int8 copy of an MLP for inference only. Weights are int8
+// with one scale per output neuron; activations between layers are 7-bit
+// (0..127, see BlasInt8.h), which a sigmoid output in (0, 1) fits with no
+// offset. Network inputs use one affine scale calibrated from sample data.
+// Every layer is one integer GEMM followed by a per-row rescale and a
+// table-lookup sigmoid.
+class QuantizedMLP {
+private:
+    struct Layer {
+        size_t rows = 0;
+        size_t cols = 0;
+        size_t paddedCols = 0;
+        vector<int8_t, AlignedAllocator<int8_t>> weights;
+        // Pre-activation of neuron j is scale[j] * accumulator + offset[j].
+        vector<float> scale;
+        vector<float> offset;
+    };
+
+    static constexpr int activationMax = 127;
+
+    // Sigmoid table over [-lutRange, lutRange]; outside it the sigmoid is
+    // within 3.4e-4 of 0 or 1.
+    static constexpr size_t lutSize = 2048;
+    static constexpr float lutRange = 8.0f;
+
+    vector<int> layerSizes;
+    vector<Layer> layers;
+    float inputMin = 0.0f;
+    float inverseInputScale = 1.0f;
+    size_t maxPaddedWidth = 0;
+    size_t maxRows = 0;
+    array<uint8_t, lutSize + 1> hiddenLut{};
+    array<float, lutSize + 1> outputLut{};
+
+    static size_t padded(size_t n) {
+        return (n + blas::INT8_K_ALIGNMENT - 1) / blas::INT8_K_ALIGNMENT * blas::INT8_K_ALIGNMENT;
+    }
+
+    static float lutPosition(float z) {
+        const float position = (z + lutRange) * (float(lutSize) / (2.0f * lutRange));
+        return min(max(position, 0.0f), float(lutSize));
+    }
+
+    uint8_t hiddenActivation(float z) const {
+        return hiddenLut[size_t(lutPosition(z) + 0.5f)];
+    }
+
+    // Output neurons interpolate between table entries for a smoother loss.
+    float outputActivation(float z) const {
+        const float position = lutPosition(z);
+        const size_t index = min(size_t(position), lutSize - 1);
+        const float t = position - float(index);
+        return outputLut[index] + t * (outputLut[index + 1] - outputLut[index]);
+    }
+
+    template<typename T>
+    void quantizeInputs(const T* inputs, size_t rows, uint8_t* out) const {
+        const size_t cols = layers[0].cols;
+        const size_t ld = layers[0].paddedCols;
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t k = 0; k < cols; ++k) {
+                const float q = (float(inputs[r * cols + k]) - inputMin) * inverseInputScale;
+                out[r * ld + k] = uint8_t(min(max(q + 0.5f, 0.0f), float(activationMax)));
+            }
+            fill(out + r * ld + cols, out + (r + 1) * ld, uint8_t(0));
+        }
+    }
+
+    struct Scratch {
+        vector<uint8_t, AlignedAllocator<uint8_t>> activations[2];
+        vector<int32_t, AlignedAllocator<int32_t>> accumulators;
+    };
+
+    // Per-thread buffers that only grow, as in MLP::inferenceScratch.
+    static Scratch& inferenceScratch(size_t activationBytes, size_t accumulatorCount) {
+        static thread_local Scratch scratch;
+        for (auto& buffer : scratch.activations) {
+            if (buffer.size() < activationBytes) {
+                buffer.resize(activationBytes);
+            }
+        }
+        if (scratch.accumulators.size() < accumulatorCount) {
+            scratch.accumulators.resize(accumulatorCount);
+        }
+        return scratch;
+    }
+
+    QuantizedMLP() {
+        for (size_t i = 0; i <= lutSize; ++i) {
+            const double z = -double(lutRange) + 2.0 * double(lutRange) * double(i) / double(lutSize);
+            const double s = 1.0 / (1.0 + exp(-z));
+            hiddenLut[i] = uint8_t(lround(s * activationMax));
+            outputLut[i] = float(s);
+        }
+    }
+
+public:
+    // Quantizes a trained model. The input range is calibrated on up to
+    // maxCalibrationSamples samples spread evenly over calibrationInputs,
+    // normally a slice of the training set.
+    template<typename T>
+    static QuantizedMLP quantize(const MLP<T>& model, const vector<Matrix<T>>& calibrationInputs, size_t maxCalibrationSamples = 1024) {
+        QuantizedMLP q;
+        q.layerSizes = model.getLayerSizes();
+
+        float low = 0.0f;
+        float high = 1.0f;
+        if (!calibrationInputs.empty()) {
+            low = high = float(calibrationInputs[0].getData()[0]);
+            const size_t count = min(maxCalibrationSamples, calibrationInputs.size());
+            for (size_t s = 0; s < count; ++s) {
+                const Matrix<T>& sample = calibrationInputs[s * calibrationInputs.size() / count];
+                for (size_t k = 0; k < sample.size(); ++k) {
+                    low = min(low, float(sample.getData()[k]));
+                    high = max(high, float(sample.getData()[k]));
+                }
+            }
+        }
+        const float inputScale = high > low ? (high - low) / float(activationMax) : 1.0f;
+        q.inputMin = low;
+        q.inverseInputScale = 1.0f / inputScale;
+
+        for (size_t i = 0; i + 1 < q.layerSizes.size(); ++i) {
+            const Matrix<T>& w = model.getWeights(i);
+            const Matrix<T>& b = model.getBiases(i);
+            Layer layer;
+            layer.rows = w.getRows();
+            layer.cols = w.getCols();
+            layer.paddedCols = padded(layer.cols);
+            layer.weights.assign(layer.rows * layer.paddedCols, 0);
+
+            for (size_t j = 0; j < layer.rows; ++j) {
+                double largest = 0.0;
+                for (size_t k = 0; k < layer.cols; ++k) {
+                    largest = max(largest, fabs(double(w(j, k))));
+                }
+                const double weightScale = largest > 0.0 ? largest / 127.0 : 1.0;
+
+                long rowSum = 0;
+                for (size_t k = 0; k < layer.cols; ++k) {
+                    const long value = lround(double(w(j, k)) / weightScale);
+                    layer.weights[j * layer.paddedCols + k] = int8_t(max(-127L, min(127L, value)));
+                    rowSum += layer.weights[j * layer.paddedCols + k];
+                }
+
+                // Layer 0 sees x = inputScale * q + inputMin, so the zero
+                // offset folds into the bias; hidden layers see s = q / 127.
+                if (i == 0) {
+                    layer.scale.push_back(float(weightScale * inputScale));
+                    layer.offset.push_back(float(double(b(j, 0)) + weightScale * double(low) * double(rowSum)));
+                } else {
+                    layer.scale.push_back(float(weightScale / activationMax));
+                    layer.offset.push_back(float(b(j, 0)));
+                }
+            }
+
+            q.maxPaddedWidth = max(q.maxPaddedWidth, layer.paddedCols);
+            q.maxPaddedWidth = max(q.maxPaddedWidth, padded(layer.rows));
+            q.maxRows = max(q.maxRows, layer.rows);
+            q.layers.push_back(move(layer));
+        }
+        return q;
+    }
+
+    const vector<int>& getLayerSizes() const { return layerSizes; }
+    size_t inputSize() const { return size_t(layerSizes.front()); }
+    size_t outputSize() const { return size_t(layerSizes.back()); }
+
+    // Bytes held by weights, scales and offsets.
+    size_t modelBytes() const {
+        size_t bytes = 0;
+        for (const Layer& layer : layers) {
+            bytes += layer.weights.size() + (layer.scale.size() + layer.offset.size()) * sizeof(float);
+        }
+        return bytes;
+    }
+
+    // Same contract as MLP::predictBatch: count row-major samples in, count
+    // row-major outputs out.
+    template<typename T>
+    void predictBatch(const T* inputs, size_t count, T* outputs) const {
+        constexpr size_t blockRows = 64;
+        Scratch& scratch = inferenceScratch(blockRows * maxPaddedWidth, blockRows * maxRows);
+
+        for (size_t first = 0; first < count; first += blockRows) {
+            const size_t rows = min(blockRows, count - first);
+            uint8_t* current = scratch.activations[0].data();
+            quantizeInputs(inputs + first * inputSize(), rows, current);
+
+            for (size_t i = 0; i < layers.size(); ++i) {
+                const Layer& layer = layers[i];
+                int32_t* acc = scratch.accumulators.data();
+                blas::gemmU8S8(rows, layer.rows, layer.paddedCols, current, layer.paddedCols, layer.weights.data(), layer.paddedCols, acc, layer.rows);
+
+                if (i + 1 == layers.size()) {
+                    T* out = outputs + first * layer.rows;
+                    for (size_t r = 0; r < rows; ++r) {
+                        for (size_t j = 0; j < layer.rows; ++j) {
+                            out[r * layer.rows + j] = T(outputActivation(layer.scale[j] * float(acc[r * layer.rows + j]) + layer.offset[j]));
+                        }
+                    }
+                    break;
+                }
+
+                uint8_t* next = scratch.activations[(i + 1) % 2].data();
+                const size_t ld = layers[i + 1].paddedCols;
+                for (size_t r = 0; r < rows; ++r) {
+                    for (size_t j = 0; j < layer.rows; ++j) {
+                        next[r * ld + j] = hiddenActivation(layer.scale[j] * float(acc[r * layer.rows + j]) + layer.offset[j]);
+                    }
+                    fill(next + r * ld + layer.rows, next + (r + 1) * ld, uint8_t(0));
+                }
+                current = next;
+            }
+        }
+    }
+
+    template<typename T>
+    void predict(const T* input, T* output) const {
+        predictBatch(input, 1, output);
+    }
+
+    // Loss, exact-match accuracy and, with perOutput, per-output accuracy
+    // and confusion counts, scored by the same MetricTotals as
+    // MLP::computeMetrics so the two compare directly. Predictions are made
+    // with predictBatch a block of rows at a time.
+    template<typename T>
+    Metrics<T> computeMetrics(const vector<Matrix<T>>& inputs, const vector<Matrix<T>>& targets, bool perOutput = false, T threshold = T(0.5)) const {
+        constexpr size_t blockRows = 256;
+        if (targets.size() != inputs.size()) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+        MetricTotals<T, typename MLP<T>::Accumulator> totals(outputSize(), perOutput);
+        vector<T> features(blockRows * inputSize());
+        vector<T> outputs(blockRows * outputSize());
+
+        for (size_t first = 0; first < inputs.size(); first += blockRows) {
+            const size_t rows = min(blockRows, inputs.size() - first);
+            for (size_t r = 0; r < rows; ++r) {
+                const Matrix<T>& sample = inputs[first + r];
+                if (sample.size() != inputSize() || targets[first + r].size() != outputSize()) {
+                    throw invalid_argument("Sample size does not match the network's layer size");
+                }
+                copy(sample.getData(), sample.getData() + inputSize(), features.data() + r * inputSize());
+            }
+            predictBatch(features.data(), rows, outputs.data());
+            // One row-major sample is a single column of stride 1.
+            for (size_t r = 0; r < rows; ++r) {
+                totals.add(outputs.data() + r * outputSize(), targets[first + r].getData(), 1, outputSize(), 1, threshold);
+            }
+        }
+        return totals.finish();
+    }
+
+    // Fraction of samples whose thresholded outputs all match; 0 for an
+    // empty set.
+    template<typename T>
+    T calculateAccuracy(const vector<Matrix<T>>& testInputs, const vector<Matrix<T>>& testTargets, T threshold = T(0.5)) const {
+        return computeMetrics(testInputs, testTargets, false, threshold).accuracy;
+    }
+};
+
+#endif // QUANTIZED_MLP_H
@@ -0,0 +1,78 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <array>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel
+// random numbers: as easy as 1, 2, 3"). A 128-bit counter and a 64-bit key
+// go in and four 32-bit words come out, with no state in between. Value i
+// of a stream is therefore a pure function of (seed, stream, i), and any
+// range of any stream can be generated on any thread in any order.
+class Philox {
+public:
+    using Block = array<uint32_t, 4>;
+
+    static Block generate(uint64_t counter, uint64_t stream, uint64_t key) {
+        Block x = {uint32_t(counter), uint32_t(counter >> 32), uint32_t(stream), uint32_t(stream >> 32)};
+        uint32_t k0 = uint32_t(key);
+        uint32_t k1 = uint32_t(key >> 32);
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = uint64_t(0xD2511F53u) * x[0];
+            const uint64_t p1 = uint64_t(0xCD9E8D57u) * x[2];
+            x = {uint32_t(p1 >> 32) ^ x[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ x[3] ^ k1, uint32_t(p0)};
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        return x;
+    }
+
+    // 53 random bits from two words as a double in [0, 1).
+    static double toUnit(uint32_t high, uint32_t low) {
+        return double(((uint64_t(high) << 32) | low) >> 11) * 0x1.0p-53;
+    }
+};
+
+// A 64-bit seed from random_device, for callers that want a fresh start.
+inline uint64_t randomSeed() {
+    random_device rd;
+    return (uint64_t(rd()) << 32) | rd();
+}
+
+// Values [first, first + count) of a stream, uniform in [low, high). Value
+// i comes from half of block i / 2, so a range gives the same numbers
+// however it is split.
+template<typename T>
+void philoxUniform(uint64_t seed, uint64_t stream, uint64_t first, size_t count, T low, T high, T* out) {
+    const double scale = double(high) - double(low);
+    for (size_t j = 0; j < count;) {
+        const uint64_t index = first + j;
+        const Philox::Block block = Philox::generate(index / 2, stream, seed);
+        for (uint64_t half = index % 2; half < 2 && j < count; ++half, ++j) {
+            out[j] = T(double(low) + scale * Philox::toUnit(block[2 * half], block[2 * half + 1]));
+        }
+    }
+}
+
+// Same layout for normal values: block i / 2 gives one Box-Muller pair, the
+// even value taking the cosine and the odd one the sine.
+template<typename T>
+void philoxNormal(uint64_t seed, uint64_t stream, uint64_t first, size_t count, T mean, T stddev, T* out) {
+    constexpr double twoPi = 6.283185307179586476925;
+    for (size_t j = 0; j < count;) {
+        const uint64_t index = first + j;
+        const Philox::Block block = Philox::generate(index / 2, stream, seed);
+        const double radius = sqrt(-2.0 * log(1.0 - Philox::toUnit(block[0], block[1])));
+        const double angle = twoPi * Philox::toUnit(block[2], block[3]);
+        for (uint64_t half = index % 2; half < 2 && j < count; ++half, ++j) {
+            out[j] = T(double(mean) + double(stddev) * radius * (half == 0 ? cos(angle) : sin(angle)));
+        }
+    }
+}
+
+#endif // RANDOM_H
@@ -0,0 +1,78 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Matrix.h"
+
+using namespace std;
+
+// Compressed sparse row copy of a dense weight matrix: row r's nonzeros are
+// values[rowStart[r] .. rowStart[r + 1]) at columns[...] in increasing
+// column order. Built from a pruned layer, so exact zeros are dropped.
+template<typename T>
+class CsrMatrix {
+private:
+    size_t rows = 0;
+    size_t cols = 0;
+    vector<uint32_t> rowStart;
+    vector<uint32_t> columns;
+    vector<T> values;
+
+public:
+    CsrMatrix() = default;
+
+    explicit CsrMatrix(const Matrix<T>& dense) : rows(dense.getRows()), cols(dense.getCols()) {
+        if (cols > UINT32_MAX || dense.size() > UINT32_MAX) {
+            throw invalid_argument("Matrix is too large for 32-bit CSR indices");
+        }
+        rowStart.reserve(rows + 1);
+        rowStart.push_back(0);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < cols; ++c) {
+                const T value = dense(r, c);
+                if (value != T{}) {
+                    columns.push_back(uint32_t(c));
+                    values.push_back(value);
+                }
+            }
+            rowStart.push_back(uint32_t(values.size()));
+        }
+    }
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t nonZeros() const { return values.size(); }
+    bool empty() const { return rows == 0; }
+
+    // Fraction of entries that are zero.
+    double sparsity() const {
+        return rows * cols == 0 ? 0.0 : 1.0 - double(values.size()) / double(rows * cols);
+    }
+
+    // Bytes of values and indices, to compare with rows * cols * sizeof(T).
+    size_t bytes() const {
+        return values.size() * sizeof(T) + (columns.size() + rowStart.size()) * sizeof(uint32_t);
+    }
+
+    // C = this * B for a dense B with cols() rows of n columns; C is
+    // overwritten.
+    void multiply(size_t n, const T* B, size_t ldb, T* C, size_t ldc) const {
+        blas::spmm(rows, n, rowStart.data(), columns.data(), values.data(), B, ldb, C, ldc);
+    }
+
+    // y = this * x for a single vector.
+    void multiplyVector(const T* x, T* y) const {
+        for (size_t r = 0; r < rows; ++r) {
+            T sum = T{};
+            for (uint32_t p = rowStart[r]; p < rowStart[r + 1]; ++p) {
+                sum += values[p] * x[columns[p]];
+            }
+            y[r] = sum;
+        }
+    }
+};
+
+#endif // SPARSE_MATRIX_H
@@ -0,0 +1,407 @@
+#ifndef STATIC_MLP_H
+#define STATIC_MLP_H
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "MLP.h"
+
+using namespace std;
+
+// MLP whose architecture is fixed at compile time, e.g. StaticMLP<double, 5, 16, 3>.
+// Parameters live in flat std::array storage and every layer's dimensions
+// are constants, so the per-layer loops can be fully unrolled and vectorized.
+// Forward, training and evaluation follow MLP<T>: sigmoid on every layer,
+// full-batch gradient descent on the mean squared error with one update per
+// epoch, loss and gradient sums in MLP<T>::Accumulator, and pruned weights
+// held at zero. There are no optimizer, schedule, mini-batch or early
+// stopping settings; training matches an MLP on its defaults (plain SGD at a
+// constant rate). Conversions to and from MLP<T> copy the parameters and
+// pruning masks.
+template<typename T, int... Layers>
+class StaticMLP {
+    static_assert(sizeof...(Layers) >= 2, "StaticMLP needs an input and an output layer");
+    static_assert(((Layers > 0) && ...), "Layer sizes must be positive");
+
+public:
+    using Accumulator = typename MLP<T>::Accumulator;
+
+    static constexpr size_t layerCount = sizeof...(Layers);
+    static constexpr array<size_t, layerCount> layerSizes = {size_t(Layers)...};
+    static constexpr size_t inputSize = layerSizes.front();
+    static constexpr size_t outputSize = layerSizes.back();
+
+private:
+    static constexpr size_t maxWidth() {
+        size_t width = 0;
+        for (size_t size : layerSizes) {
+            width = size > width ? size : width;
+        }
+        return width;
+    }
+
+    // Layer L maps layerSizes[L] inputs to layerSizes[L + 1] outputs. Its
+    // weights are stored transposed (one contiguous column per input, so the
+    // inner loops run across output neurons) from weightOffset(L); its
+    // biases, activations and deltas start at neuronOffset(L).
+    static constexpr size_t weightOffset(size_t layer) {
+        size_t offset = 0;
+        for (size_t i = 0; i < layer; ++i) {
+            offset += layerSizes[i + 1] * layerSizes[i];
+        }
+        return offset;
+    }
+
+    static constexpr size_t neuronOffset(size_t layer) {
+        size_t offset = 0;
+        for (size_t i = 0; i < layer; ++i) {
+            offset += layerSizes[i + 1];
+        }
+        return offset;
+    }
+
+    static constexpr size_t weightCount = weightOffset(layerCount - 1);
+    static constexpr size_t neuronCount = neuronOffset(layerCount - 1);
+
+    alignas(MATRIX_ALIGNMENT) array<T, weightCount> weights;
+    alignas(MATRIX_ALIGNMENT) array<T, neuronCount> biases;
+    T learningRate;
+    blas::SigmoidMode sigmoidMode;
+    // Pruning mask in the weights' layout, 0 where a weight is held at zero;
+    // empty for a dense model.
+    vector<T> weightMask;
+
+    // Per-sample training buffers and the epoch's gradient sums. Kept off the
+    // stack so wide networks do not overflow it.
+    struct TrainingState {
+        array<T, neuronCount> activations;
+        array<T, neuronCount> derivatives;
+        array<T, neuronCount> deltas;
+        array<Accumulator, weightCount> weightGradients;
+        array<Accumulator, neuronCount> biasGradients;
+    };
+
+    // out = sigmoid(W[L] * in + b[L]), with s(1-s) written to derivatives
+    // when it is non-null.
+    template<size_t L>
+    void layerForward(const T* in, T* out, T* derivatives) const {
+        constexpr size_t rows = layerSizes[L + 1];
+        constexpr size_t cols = layerSizes[L];
+        const T* w = weights.data() + weightOffset(L);
+        const T* b = biases.data() + neuronOffset(L);
+
+        for (size_t j = 0; j < rows; ++j) {
+            out[j] = T{};
+        }
+        for (size_t k = 0; k < cols; ++k) {
+            const T x = in[k];
+            for (size_t j = 0; j < rows; ++j) {
+                out[j] += w[k * rows + j] * x;
+            }
+        }
+        for (size_t j = 0; j < rows; ++j) {
+            out[j] += b[j];
+        }
+        blas::sigmoid(rows, out, T{}, derivatives, sigmoidMode);
+    }
+
+    template<size_t L>
+    void propagate(const T* in, T* output, T (&scratch)[2][maxWidth()]) const {
+        if constexpr (L + 2 == layerCount) {
+            layerForward<L>(in, output, nullptr);
+        } else {
+            layerForward<L>(in, scratch[L % 2], nullptr);
+            propagate<L + 1>(scratch[L % 2], output, scratch);
+        }
+    }
+
+    template<size_t L>
+    static const T* layerInput(const T* input, const TrainingState& state) {
+        if constexpr (L == 0) {
+            return input;
+        } else {
+            return state.activations.data() + neuronOffset(L - 1);
+        }
+    }
+
+    template<size_t L>
+    void forwardTraining(const T* input, TrainingState& state) const {
+        const T* in = layerInput<L>(input, state);
+        layerForward<L>(in, state.activations.data() + neuronOffset(L), state.derivatives.data() + neuronOffset(L));
+        if constexpr (L + 2 < layerCount) {
+            forwardTraining<L + 1>(input, state);
+        }
+    }
+
+    // deltas[L] = (W[L + 1]^T * deltas[L + 1]) .* derivatives[L], walking
+    // down from the last hidden layer.
+    template<size_t L>
+    void backwardHidden(TrainingState& state) const {
+        constexpr size_t width = layerSizes[L + 1];
+        constexpr size_t nextWidth = layerSizes[L + 2];
+        const T* w = weights.data() + weightOffset(L + 1);
+        const T* nextDelta = state.deltas.data() + neuronOffset(L + 1);
+        T* delta = state.deltas.data() + neuronOffset(L);
+        const T* derivative = state.derivatives.data() + neuronOffset(L);
+
+        // Weights are stored transposed, so W^T * delta is a row-major GEMV.
+        blas::gemvHadamard(width, nextWidth, w, nextWidth, nextDelta, derivative, delta);
+        if constexpr (L > 0) {
+            backwardHidden<L - 1>(state);
+        }
+    }
+
+    template<size_t L>
+    void accumulateGradients(const T* input, TrainingState& state) const {
+        constexpr size_t rows = layerSizes[L + 1];
+        constexpr size_t cols = layerSizes[L];
+        const T* in = layerInput<L>(input, state);
+        const T* delta = state.deltas.data() + neuronOffset(L);
+        Accumulator* gradient = state.weightGradients.data() + weightOffset(L);
+        Accumulator* biasGradient = state.biasGradients.data() + neuronOffset(L);
+
+        if constexpr (is_same<T, Accumulator>::value) {
+            blas::ger(cols, rows, in, delta, gradient, rows);
+        } else {
+            for (size_t k = 0; k < cols; ++k) {
+                for (size_t j = 0; j < rows; ++j) {
+                    gradient[k * rows + j] += Accumulator(in[k] * delta[j]);
+                }
+            }
+        }
+        for (size_t j = 0; j < rows; ++j) {
+            biasGradient[j] += Accumulator(delta[j]);
+        }
+        if constexpr (L + 2 < layerCount) {
+            accumulateGradients<L + 1>(input, state);
+        }
+    }
+
+    // One sample's forward and backward pass; returns its squared error.
+    Accumulator trainSample(const T* input, const T* target, TrainingState& state) const {
+        forwardTraining<0>(input, state);
+
+        constexpr size_t last = neuronOffset(layerCount - 2);
+        Accumulator loss = Accumulator{};
+        for (size_t i = 0; i < outputSize; ++i) {
+            const T error = state.activations[last + i] - target[i];
+            loss += Accumulator(error) * Accumulator(error);
+            state.deltas[last + i] = T(2.0) * error * state.derivatives[last + i];
+        }
+
+        if constexpr (layerCount > 2) {
+            backwardHidden<layerCount - 3>(state);
+        }
+        accumulateGradients<0>(input, state);
+        return loss;
+    }
+
+    static void checkShape(const Matrix<T>& m, size_t rows, size_t cols) {
+        if (m.getRows() != rows || m.getCols() != cols) {
+            throw invalid_argument("MLP architecture does not match StaticMLP");
+        }
+    }
+
+public:
+    // Uniform parameters from a fresh random seed.
+    explicit StaticMLP(T lr = T(0.01)) : StaticMLP(lr, InitConfig{InitScheme::Uniform, randomSeed()}) {}
+
+    // The same parameters MLP<T>(architecture, lr, batch, init) starts with.
+    StaticMLP(T lr, const InitConfig& init) : learningRate(lr), sigmoidMode(blas::SigmoidMode::Exact) {
+        vector<T> layerWeights;
+        for (size_t layer = 0; layer + 1 < layerCount; ++layer) {
+            const size_t rows = layerSizes[layer + 1];
+            const size_t cols = layerSizes[layer];
+            layerWeights.resize(rows * cols);
+            initialParameters(init, layer, false, cols, rows, 0, rows * cols, layerWeights.data());
+            for (size_t j = 0; j < rows; ++j) {
+                for (size_t k = 0; k < cols; ++k) {
+                    weights[weightOffset(layer) + k * rows + j] = layerWeights[j * cols + k];
+                }
+            }
+            initialParameters(init, layer, true, cols, rows, 0, rows, biases.data() + neuronOffset(layer));
+        }
+    }
+
+    // Copies the parameters, pruning masks, learning rate and sigmoid mode of
+    // a runtime MLP with the same architecture.
+    explicit StaticMLP(const MLP<T>& source) : learningRate(source.getLearningRate()), sigmoidMode(source.getSigmoidMode()) {
+        const vector<int>& sizes = source.getLayerSizes();
+        if (sizes.size() != layerCount || !equal(sizes.begin(), sizes.end(), layerSizes.begin(), [](int a, size_t b) { return size_t(a) == b; })) {
+            throw invalid_argument("MLP architecture does not match StaticMLP");
+        }
+
+        for (size_t layer = 0; layer + 1 < layerCount; ++layer) {
+            const Matrix<T>& w = source.getWeights(layer);
+            const Matrix<T>& b = source.getBiases(layer);
+            checkShape(w, layerSizes[layer + 1], layerSizes[layer]);
+            checkShape(b, layerSizes[layer + 1], 1);
+            for (size_t j = 0; j < w.getRows(); ++j) {
+                for (size_t k = 0; k < w.getCols(); ++k) {
+                    weights[weightOffset(layer) + k * w.getRows() + j] = w(j, k);
+                }
+            }
+            copy(b.getData(), b.getData() + b.size(), biases.data() + neuronOffset(layer));
+        }
+
+        if (source.hasWeightMasks()) {
+            weightMask.resize(weightCount);
+            for (size_t layer = 0; layer + 1 < layerCount; ++layer) {
+                const Matrix<T>& mask = source.getWeightMask(layer);
+                for (size_t j = 0; j < mask.getRows(); ++j) {
+                    for (size_t k = 0; k < mask.getCols(); ++k) {
+                        weightMask[weightOffset(layer) + k * mask.getRows() + j] = mask(j, k);
+                    }
+                }
+            }
+        }
+    }
+
+    MLP<T> toMLP() const {
+        MLP<T> result(vector<int>{Layers...}, learningRate);
+        result.setSigmoidMode(sigmoidMode);
+
+        for (size_t layer = 0; layer + 1 < layerCount; ++layer) {
+            Matrix<T> w(layerSizes[layer + 1], layerSizes[layer]);
+            Matrix<T> b(layerSizes[layer + 1], 1);
+            for (size_t j = 0; j < w.getRows(); ++j) {
+                for (size_t k = 0; k < w.getCols(); ++k) {
+                    w(j, k) = weights[weightOffset(layer) + k * w.getRows() + j];
+                }
+            }
+            copy(biases.data() + neuronOffset(layer), biases.data() + neuronOffset(layer + 1), b.getData());
+            result.setParameters(layer, w, b);
+        }
+
+        if (!weightMask.empty()) {
+            vector<Matrix<T>> masks;
+            for (size_t layer = 0; layer + 1 < layerCount; ++layer) {
+                Matrix<T> mask(layerSizes[layer + 1], layerSizes[layer]);
+                for (size_t j = 0; j < mask.getRows(); ++j) {
+                    for (size_t k = 0; k < mask.getCols(); ++k) {
+                        mask(j, k) = weightMask[weightOffset(layer) + k * mask.getRows() + j];
+                    }
+                }
+                masks.push_back(mask);
+            }
+            result.setWeightMasks(masks);
+        }
+        return result;
+    }
+
+    T getLearningRate() const { return learningRate; }
+    void setLearningRate(T lr) { learningRate = lr; }
+
+    blas::SigmoidMode getSigmoidMode() const { return sigmoidMode; }
+    void setSigmoidMode(blas::SigmoidMode mode) { sigmoidMode = mode; }
+
+    bool hasWeightMasks() const { return !weightMask.empty(); }
+
+    // Reads inputSize features and writes outputSize values; intermediate
+    // layers stay in two stack rows of the widest layer's size.
+    void predict(const T* input, T* output) const {
+        T scratch[2][maxWidth()];
+        propagate<0>(input, output, scratch);
+    }
+
+    array<T, outputSize> predict(const array<T, inputSize>& input) const {
+        array<T, outputSize> output;
+        predict(input.data(), output.data());
+        return output;
+    }
+
+    Matrix<T> forward(const Matrix<T>& input) const {
+        if (input.size() != inputSize) {
+            throw invalid_argument("Input size does not match the network's input layer");
+        }
+        Matrix<T> output(outputSize, 1);
+        predict(input.getData(), output.getData());
+        return output;
+    }
+
+    // Trains for epochs epochs and returns how many ran, as
+    // MLP::trainWithValidation does; with no early stopping that is always
+    // epochs.
+    int trainWithValidation(const vector<Matrix<T>>& trainInputs, const vector<Matrix<T>>& trainTargets, const vector<Matrix<T>>& valInputs, const vector<Matrix<T>>& valTargets, int epochs, bool verbose = true) {
+        if (trainTargets.size() != trainInputs.size()) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+        for (size_t sample = 0; sample < trainInputs.size(); ++sample) {
+            if (trainInputs[sample].size() != inputSize || trainTargets[sample].size() != outputSize) {
+                throw invalid_argument("Sample size does not match the network's layer size");
+            }
+        }
+
+        unique_ptr<TrainingState> state(new TrainingState());
+        const Accumulator sampleCount = Accumulator(trainInputs.size());
+        const Accumulator scale = trainInputs.empty() ? Accumulator{} : Accumulator(1.0) / sampleCount;
+
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            state->weightGradients.fill(Accumulator{});
+            state->biasGradients.fill(Accumulator{});
+
+            Accumulator totalLoss = Accumulator{};
+            for (size_t sample = 0; sample < trainInputs.size(); ++sample) {
+                totalLoss += trainSample(trainInputs[sample].getData(), trainTargets[sample].getData(), *state);
+            }
+
+            for (size_t i = 0; i < weightCount; ++i) {
+                weights[i] = weights[i] - learningRate * T(state->weightGradients[i] * scale);
+            }
+            for (size_t i = 0; i < weightMask.size(); ++i) {
+                if (weightMask[i] == T{}) {
+                    weights[i] = T{};
+                }
+            }
+            for (size_t i = 0; i < neuronCount; ++i) {
+                biases[i] = biases[i] - learningRate * T(state->biasGradients[i] * scale);
+            }
+
+            if (verbose && epoch % 100 == 0) {
+                cout << "Epoch " << epoch << " - Train Loss: " << T(totalLoss * scale);
+                if (!valInputs.empty()) {
+                    cout << ", Val Loss: " << evaluate(valInputs, valTargets);
+                }
+                cout << endl;
+            }
+        }
+        return max(epochs, 0);
+    }
+
+    // Loss, exact-match accuracy and, with perOutput, per-output accuracy
+    // and confusion counts, summed through the same MetricTotals as
+    // MLP::computeMetrics so the two report the same numbers.
+    Metrics<T> computeMetrics(const vector<Matrix<T>>& inputs, const vector<Matrix<T>>& targets, bool perOutput = false, T threshold = T(0.5)) const {
+        if (targets.size() != inputs.size()) {
+            throw invalid_argument("Input and target sample counts differ");
+        }
+        MetricTotals<T, typename MLP<T>::Accumulator> totals(outputSize, perOutput);
+        array<T, outputSize> output;
+
+        for (size_t sample = 0; sample < inputs.size(); ++sample) {
+            if (inputs[sample].size() != inputSize || targets[sample].size() != outputSize) {
+                throw invalid_argument("Sample size does not match the network's layer size");
+            }
+            predict(inputs[sample].getData(), output.data());
+            // One sample is a single column of stride 1.
+            totals.add(output.data(), targets[sample].getData(), 1, outputSize, 1, threshold);
+        }
+        return totals.finish();
+    }
+
+    T evaluate(const vector<Matrix<T>>& testInputs, const vector<Matrix<T>>& testTargets) const {
+        return computeMetrics(testInputs, testTargets).loss;
+    }
+
+    // Fraction of samples whose thresholded outputs all match; 0 for an
+    // empty set.
+    T calculateAccuracy(const vector<Matrix<T>>& testInputs, const vector<Matrix<T>>& testTargets, T threshold = T(0.5)) const {
+        return computeMetrics(testInputs, testTargets, false, threshold).accuracy;
+    }
+};
+
+#endif // STATIC_MLP_H
@@ -0,0 +1,314 @@
+#ifndef SYNTHETIC_DATA_H
+#define SYNTHETIC_DATA_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include "Random.h"
+#include "ThreadPool.h"
+#include "CsvLoader.h"
+#include "DataStream.h"
+#include "BinaryDataset.h"
+
+using namespace std;
+
+// Boolean-circuit datasets of any size, for exercising training at scale:
+//   Adder   a0..a{n-1}, b0..b{n-1}, c0 -> s0..s{n-1}, c{n}   s = a + b + c0
+//   Xor     a0..a{n-1}, b0..b{n-1}     -> y0..y{n-1}         y = a ^ b
+//   Parity  x0..x{n-1}                 -> y                  odd number of ones
+// Bit 0 is the least significant and every value is 0 or 1.
+enum class SyntheticTask { Adder, Xor, Parity };
+
+struct SyntheticConfig {
+    SyntheticTask task = SyntheticTask::Adder;
+    // Operand width in bits.
+    size_t bits = 2;
+    // Adder only: without a carry-in column the carry in is 0.
+    bool carryIn = true;
+    // 0 enumerates all 2^inputs patterns in counting order, the first column
+    // most significant like the bundled CSVs; otherwise this many rows are
+    // drawn uniformly with replacement.
+    size_t rows = 0;
+    // Sampled row r is a pure function of (seed, r), so the data is the same
+    // however it is split across threads.
+    uint64_t seed = 0;
+};
+
+inline const char* syntheticTaskName(SyntheticTask task) {
+    switch (task) {
+        case SyntheticTask::Adder: return "adder";
+        case SyntheticTask::Xor: return "xor";
+        case SyntheticTask::Parity: return "parity";
+    }
+    return "unknown";
+}
+
+inline size_t syntheticInputs(const SyntheticConfig& config) {
+    switch (config.task) {
+        case SyntheticTask::Adder: return 2 * config.bits + (config.carryIn ? 1 : 0);
+        case SyntheticTask::Xor: return 2 * config.bits;
+        case SyntheticTask::Parity: return config.bits;
+    }
+    return 0;
+}
+
+inline size_t syntheticOutputs(const SyntheticConfig& config) {
+    switch (config.task) {
+        case SyntheticTask::Adder: return config.bits + 1;
+        case SyntheticTask::Xor: return config.bits;
+        case SyntheticTask::Parity: return 1;
+    }
+    return 0;
+}
+
+inline size_t syntheticRows(const SyntheticConfig& config) {
+    if (config.bits == 0) {
+        throw invalid_argument("Synthetic datasets need at least one bit");
+    }
+    if (config.rows > 0) {
+        return config.rows;
+    }
+    if (syntheticInputs(config) >= 64) {
+        throw invalid_argument("Exhaustive datasets need fewer than 64 inputs; set a row count");
+    }
+    return size_t(1) << syntheticInputs(config);
+}
+
+inline CsvColumns syntheticColumns(const SyntheticConfig& config) {
+    CsvColumns columns;
+    const size_t n = config.bits;
+    if (config.task == SyntheticTask::Parity) {
+        for (size_t i = 0; i < n; ++i) {
+            columns.inputs.push_back("x" + to_string(i));
+        }
+        columns.outputs.push_back("y");
+        return columns;
+    }
+    for (const char* operand : {"a", "b"}) {
+        for (size_t i = 0; i < n; ++i) {
+            columns.inputs.push_back(operand + to_string(i));
+        }
+    }
+    if (config.task == SyntheticTask::Adder) {
+        if (config.carryIn) {
+            columns.inputs.push_back("c0");
+        }
+        for (size_t i = 0; i < n; ++i) {
+            columns.outputs.push_back("s" + to_string(i));
+        }
+        columns.outputs.push_back("c" + to_string(n));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            columns.outputs.push_back("y" + to_string(i));
+        }
+    }
+    return columns;
+}
+
+// Rows [first, first + count) into row-major features (count x inputs) and
+// labels (count x outputs).
+template<typename T>
+void generateSynthetic(const SyntheticConfig& config, size_t first, size_t count, T* features, T* labels) {
+    const size_t in = syntheticInputs(config);
+    const size_t out = syntheticOutputs(config);
+    const size_t n = config.bits;
+    vector<uint32_t> x(in);
+
+    for (size_t r = 0; r < count; ++r) {
+        const uint64_t row = first + r;
+        if (config.rows == 0) {
+            for (size_t k = 0; k < in; ++k) {
+                x[k] = uint32_t(row >> (in - 1 - k)) & 1u;
+            }
+        } else {
+            // 128 inputs per Philox block, block j of a row from stream j.
+            for (size_t k = 0; k < in; k += 128) {
+                const Philox::Block block = Philox::generate(row, k / 128, config.seed);
+                for (size_t b = k; b < min(in, k + 128); ++b) {
+                    x[b] = (block[(b - k) / 32] >> ((b - k) % 32)) & 1u;
+                }
+            }
+        }
+
+        T* f = features + r * in;
+        T* y = labels + r * out;
+        for (size_t k = 0; k < in; ++k) {
+            f[k] = T(x[k]);
+        }
+        switch (config.task) {
+            case SyntheticTask::Adder: {
+                uint32_t carry = config.carryIn ? x[2 * n] : 0u;
+                for (size_t i = 0; i < n; ++i) {
+                    const uint32_t sum = x[i] + x[n + i] + carry;
+                    y[i] = T(sum & 1u);
+                    carry = sum >> 1;
+                }
+                y[n] = T(carry);
+                break;
+            }
+            case SyntheticTask::Xor:
+                for (size_t i = 0; i < n; ++i) {
+                    y[i] = T(x[i] ^ x[n + i]);
+                }
+                break;
+            case SyntheticTask::Parity: {
+                uint32_t parity = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    parity ^= x[i];
+                }
+                y[0] = T(parity);
+                break;
+            }
+        }
+    }
+}
+
+namespace synthetic {
+
+constexpr size_t blockRows = size_t(1) << 16;
+
+// Generates the dataset a block per thread at a time and hands the blocks
+// to write(first, count, features, labels) in row order, so memory stays
+// at one block per thread however many rows there are.
+template<typename T, typename Write>
+void generateBlocks(const SyntheticConfig& config, size_t threads, Write write) {
+    const size_t rows = syntheticRows(config);
+    const size_t in = syntheticInputs(config);
+    const size_t out = syntheticOutputs(config);
+    if (threads == 0) {
+        threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+    threads = max<size_t>(1, min(threads, (rows + blockRows - 1) / blockRows));
+
+    ThreadPool pool(threads);
+    vector<vector<T>> features(threads, vector<T>(blockRows * in));
+    vector<vector<T>> labels(threads, vector<T>(blockRows * out));
+    for (size_t first = 0; first < rows; first += threads * blockRows) {
+        const size_t blocks = min(threads, (rows - first + blockRows - 1) / blockRows);
+        pool.parallelFor(blocks, [&](size_t b) {
+            const size_t start = first + b * blockRows;
+            generateSynthetic(config, start, min(blockRows, rows - start), features[b].data(), labels[b].data());
+        });
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t start = first + b * blockRows;
+            write(start, min(blockRows, rows - start), features[b].data(), labels[b].data());
+        }
+    }
+}
+
+} // namespace synthetic
+
+// The whole dataset in memory, generated in blocks on threads threads
+// (0 = every core).
+template<typename T>
+CsvTable<T> makeSyntheticTable(const SyntheticConfig& config, size_t threads = 0) {
+    CsvTable<T> table;
+    table.rows = syntheticRows(config);
+    table.inputDim = syntheticInputs(config);
+    table.outputDim = syntheticOutputs(config);
+    table.features.resize(table.rows * table.inputDim);
+    table.labels.resize(table.rows * table.outputDim);
+
+    const size_t blocks = (table.rows + synthetic::blockRows - 1) / synthetic::blockRows;
+    if (threads == 0) {
+        threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+    ThreadPool pool(min(threads, blocks));
+    pool.parallelFor(blocks, [&](size_t b) {
+        const size_t first = b * synthetic::blockRows;
+        generateSynthetic(config, first, min(synthetic::blockRows, table.rows - first), table.features.data() + first * table.inputDim, table.labels.data() + first * table.outputDim);
+    });
+    return table;
+}
+
+// Streams the dataset to a headered CSV that loadCsv and dataset_convert read.
+inline void writeSyntheticCsv(const SyntheticConfig& config, const string& path, size_t threads = 0) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open file " + path);
+    }
+    const CsvColumns columns = syntheticColumns(config);
+    string header;
+    for (const vector<string>* names : {&columns.inputs, &columns.outputs}) {
+        for (const string& name : *names) {
+            header += (header.empty() ? "" : ",") + name;
+        }
+    }
+    file << header << '\n';
+
+    const size_t in = columns.inputs.size();
+    const size_t out = columns.outputs.size();
+    string text;
+    synthetic::generateBlocks<uint8_t>(config, threads, [&](size_t, size_t count, const uint8_t* features, const uint8_t* labels) {
+        text.resize(count * 2 * (in + out));
+        char* p = &text[0];
+        for (size_t r = 0; r < count; ++r) {
+            for (size_t k = 0; k < in + out; ++k) {
+                *p++ = char('0' + (k < in ? features[r * in + k] : labels[r * out + k - in]));
+                *p++ = k + 1 < in + out ? ',' : '\n';
+            }
+        }
+        file.write(text.data(), streamsize(text.size()));
+    });
+    if (!file) {
+        throw runtime_error("Failed writing " + path);
+    }
+}
+
+// Streams the dataset to a binary dataset file (see BinaryDataset.h): each
+// block's features and labels go straight to their offsets in the file.
+template<typename T>
+void writeSyntheticBinary(const SyntheticConfig& config, const string& path, size_t threads = 0) {
+    const size_t in = syntheticInputs(config);
+    const size_t out = syntheticOutputs(config);
+    const BinaryDatasetHeader header = binaryDatasetHeader<T>(syntheticRows(config), in, out);
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open file " + path);
+    }
+    const char padding[BINARY_DATASET_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, streamsize(header.featureOffset - sizeof(header)));
+
+    synthetic::generateBlocks<T>(config, threads, [&](size_t first, size_t count, const T* features, const T* labels) {
+        file.seekp(streamoff(header.featureOffset + first * in * sizeof(T)));
+        file.write(reinterpret_cast<const char*>(features), streamsize(count * in * sizeof(T)));
+        file.seekp(streamoff(header.labelOffset + first * out * sizeof(T)));
+        file.write(reinterpret_cast<const char*>(labels), streamsize(count * out * sizeof(T)));
+    });
+    if (!file) {
+        throw runtime_error("Failed writing " + path);
+    }
+}
+
+// Generates rows as a DataStream reads them, for training at any size with
+// no file at all.
+template<typename T>
+class SyntheticSource : public DataSource<T> {
+private:
+    SyntheticConfig config;
+    size_t rows;
+    size_t next = 0;
+
+public:
+    explicit SyntheticSource(const SyntheticConfig& syntheticConfig) : config(syntheticConfig), rows(syntheticRows(syntheticConfig)) {}
+
+    size_t inputDim() const override { return syntheticInputs(config); }
+    size_t outputDim() const override { return syntheticOutputs(config); }
+    size_t rowCount() const { return rows; }
+
+    void rewind() override { next = 0; }
+
+    size_t read(size_t maxRows, T* features, T* labels) override {
+        const size_t count = min(maxRows, rows - next);
+        generateSynthetic(config, next, count, features, labels);
+        next += count;
+        return count;
+    }
+};
+
+#endif // SYNTHETIC_DATA_H
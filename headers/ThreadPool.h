@@ -0,0 +1,136 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+using namespace std;
+
+// Fork-join pool: parallelFor hands task indices to the worker threads and the
+// calling thread, then returns once every index has run. Tasks that write only
+// to state owned by their index give the same result on every run.
+class ThreadPool {
+private:
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wakeUp;
+    condition_variable finished;
+
+    // Type-erased pointer to the caller's callable; parallelFor blocks until
+    // every task has run, so the callable outlives every use of it.
+    void (*invoke)(void*, size_t) = nullptr;
+    void* context = nullptr;
+    size_t taskCount = 0;
+    atomic<size_t> nextTask{0};
+    size_t busyWorkers = 0;
+    size_t generation = 0;
+    bool stopping = false;
+    exception_ptr failure;
+
+    void runTasks() {
+        for (size_t index = nextTask++; index < taskCount; index = nextTask++) {
+            try {
+                invoke(context, index);
+            } catch (...) {
+                unique_lock<mutex> guard(lock);
+                if (!failure) {
+                    failure = current_exception();
+                }
+            }
+        }
+    }
+
+    void workerLoop() {
+        size_t seenGeneration = 0;
+        while (true) {
+            {
+                unique_lock<mutex> guard(lock);
+                wakeUp.wait(guard, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+
+            runTasks();
+
+            unique_lock<mutex> guard(lock);
+            if (--busyWorkers == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+public:
+    // threads counts the calling thread, so ThreadPool(1) spawns nothing and
+    // runs every task inline. Zero means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = max<size_t>(1, thread::hardware_concurrency());
+        }
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            unique_lock<mutex> guard(lock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    template<typename Fn>
+    void parallelFor(size_t count, Fn&& fn) {
+        if (count == 0) {
+            return;
+        }
+
+        if (workers.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        using Callable = remove_reference_t<Fn>;
+        {
+            unique_lock<mutex> guard(lock);
+            invoke = [](void* target, size_t index) { (*static_cast<Callable*>(target))(index); };
+            context = const_cast<void*>(static_cast<const void*>(&fn));
+            taskCount = count;
+            nextTask = 0;
+            busyWorkers = workers.size();
+            failure = nullptr;
+            ++generation;
+        }
+        wakeUp.notify_all();
+
+        runTasks();
+
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&] { return busyWorkers == 0; });
+        invoke = nullptr;
+        context = nullptr;
+        if (failure) {
+            rethrow_exception(failure);
+        }
+    }
+};
+
+#endif // THREAD_POOL_H
@@ -2,16 +2,24 @@
 #include <vector>
 #include <cmath>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <cstring>
+#include <filesystem>
 
 #include <random>
 #include <iomanip>
+#include <limits>
 
 #include "headers/Complex.h"
 #include "headers/Matrix.h"
 #include "headers/MLP.h"
+#include "headers/QuantizedMLP.h"
+#include "headers/ThreadPool.h"
+#include "headers/CsvLoader.h"
+#include "headers/CommandLine.h"
 
 using namespace std;
 
@@ -34,6 +42,18 @@ struct MLPExperimentTypes {
         T learningRate;
         int epochs;
         string description;
+        size_t batchSize = 32;
+        size_t threads = 1;
+        string checkpointPath = "";
+        int checkpointInterval = 0;
+        // Off unless --early-stop sets a patience. It watches the training
+        // loss: the test split only scores the finished model, so it never
+        // picks which weights are kept.
+        EarlyStopping earlyStopping = {0, 1e-4, 10, true};
+        // Seeds both the train/test split and the initial parameters, so a
+        // config and seed always reproduce the same run.
+        int seed = 42;
+        InitScheme init = InitScheme::Uniform;
     };
 
     struct ExperimentResult {
@@ -42,55 +62,41 @@ struct MLPExperimentTypes {
         T testLoss;
         T trainAccuracy;
         T testAccuracy;
+        T int8TestAccuracy = T{};
         T splitRatio;
+        int epochsUsed = 0;
+        // Per output bit of the test set.
+        vector<T> testOutputAccuracy;
+        vector<OutputConfusion> testConfusion;
+        int seed = 42;
+        double seconds = 0.0;
+        double samplesPerSecond = 0.0;
     };
 };
 
 template<typename T>
-typename MLPExperimentTypes<T>::Dataset loadDatasetFromCSV(string filename, string datasetName) {
+typename MLPExperimentTypes<T>::Dataset loadDatasetFromCSV(string filename, string datasetName, const CsvColumns& columns) {
     typename MLPExperimentTypes<T>::Dataset dataset;
     dataset.name = datasetName;
-    
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: Cannot open file " << filename << endl;
+    dataset.inputDim = int(columns.inputs.size());
+    dataset.outputDim = int(columns.outputs.size());
+    
+    CsvTable<T> table;
+    try {
+        table = loadCsv<T>(filename, columns);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
         return dataset;
     }
     
-    string line;
-    bool isHeader = true;
-    
-    while (getline(file, line)) {
-        if (isHeader) {
-            isHeader = false;
-            continue;
-        }
-        
-        stringstream ss(line);
-        string value;
-        vector<T> values;
-        
-        while (getline(ss, value, ',')) {
-            values.push_back(T(stod(value)));
-        }
-        
-        typename MLPExperimentTypes<T>::DataSample sample;
-        if (datasetName == "XOR") {
-            sample.inputs = {values[0], values[1]};
-            sample.outputs = {values[2]};
-            dataset.inputDim = 2;
-            dataset.outputDim = 1;
-        } else if (datasetName == "Binary Adder") {
-            sample.inputs = {values[0], values[1], values[2], values[3], values[4]};
-            sample.outputs = {values[5], values[6], values[7]};
-            dataset.inputDim = 5;
-            dataset.outputDim = 3;
-        }
-        
-        dataset.samples.push_back(sample);
+    dataset.samples.resize(table.rows);
+    for (size_t row = 0; row < table.rows; ++row) {
+        const T* features = table.features.data() + row * table.inputDim;
+        const T* labels = table.labels.data() + row * table.outputDim;
+        dataset.samples[row].inputs.assign(features, features + table.inputDim);
+        dataset.samples[row].outputs.assign(labels, labels + table.outputDim);
     }
     
-    file.close();
     return dataset;
 }
 
@@ -140,41 +146,79 @@ typename MLPExperimentTypes<T>::ExperimentResult runExperiment(const typename ML
     typename MLPExperimentTypes<T>::ExperimentResult result;
     result.config = config;
     result.splitRatio = splitRatio;
+    result.seed = config.seed;
+    auto start = chrono::steady_clock::now();
     
     auto [trainInputs, trainTargets] = datasetToMatrices<T>(trainSet);
     auto [testInputs, testTargets] = datasetToMatrices<T>(testSet);
     
-    MLP<T> mlp(config.architecture, config.learningRate);
-    
-    mlp.trainWithValidation(trainInputs, trainTargets, testInputs, testTargets, config.epochs, false);
+    // With a checkpoint path, an existing checkpoint is resumed and only the
+    // remaining epochs are trained; one saved after an early stop is done.
+    MLP<T> mlp(config.architecture, config.learningRate, config.batchSize, InitConfig{config.init, uint64_t(config.seed)});
+    if (!config.checkpointPath.empty() && ifstream(config.checkpointPath).good()) {
+        try {
+            mlp = MLP<T>::loadCheckpoint(config.checkpointPath);
+        } catch (const exception& e) {
+            cerr << "Warning: " << e.what() << ", training from scratch" << endl;
+        }
+    }
+    mlp.setThreadCount(config.threads);
+    mlp.setEarlyStopping(config.earlyStopping);
+    if (!config.checkpointPath.empty()) {
+        mlp.setCheckpointing(config.checkpointPath, config.checkpointInterval);
+    }
     
-    result.trainLoss = mlp.evaluate(trainInputs, trainTargets);
-    result.testLoss = mlp.evaluate(testInputs, testTargets);
-    result.trainAccuracy = mlp.calculateAccuracy(trainInputs, trainTargets);
-    result.testAccuracy = mlp.calculateAccuracy(testInputs, testTargets);
+    const int remainingEpochs = mlp.getStoppedEarly() ? 0 : max(0, config.epochs - int(mlp.getEpochsTrained()));
+    // No validation set, so early stopping (when on) watches the training
+    // loss. The datasets are complete truth tables, too small to hold rows
+    // back from training.
+    const vector<Matrix<T>> noValidation;
+    const int epochsRun = mlp.trainWithValidation(trainInputs, trainTargets, noValidation, noValidation, remainingEpochs, false);
+    result.epochsUsed = int(mlp.getEpochsTrained());
+    
+    const Metrics<T> trainMetrics = mlp.computeMetrics(trainInputs, trainTargets);
+    const Metrics<T> testMetrics = mlp.computeMetrics(testInputs, testTargets, true);
+    result.trainLoss = trainMetrics.loss;
+    result.testLoss = testMetrics.loss;
+    result.trainAccuracy = trainMetrics.accuracy;
+    result.testAccuracy = testMetrics.accuracy;
+    result.testOutputAccuracy = testMetrics.outputAccuracy;
+    result.testConfusion = testMetrics.confusion;
+
+    // Test accuracy of the int8 model calibrated on the training inputs.
+    const QuantizedMLP quantized = QuantizedMLP::quantize(mlp, trainInputs);
+    result.int8TestAccuracy = quantized.calculateAccuracy(testInputs, testTargets);
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.samplesPerSecond = double(trainInputs.size()) * double(epochsRun) / result.seconds;
     
     return result;
 }
 
+string architectureString(const vector<int>& architecture) {
+    string archStr = "";
+    for (size_t i = 0; i < architecture.size(); ++i) {
+        archStr += to_string(architecture[i]);
+        if (i < architecture.size() - 1) archStr += "-";
+    }
+    return archStr;
+}
+
 template<typename T>
 void printResults(vector<typename MLPExperimentTypes<T>::ExperimentResult> results, string datasetName) {
-    cout << "\n" << string(120, '=') << endl;
+    cout << "\n" << string(138, '=') << endl;
     cout << "EXPERIMENT RESULTS FOR " << datasetName << " DATASET" << endl;
-    cout << string(120, '=') << endl;
+    cout << string(138, '=') << endl;
     
-    cout << left << setw(25) << "Architecture" << setw(10) << "LR" << setw(8) << "Epochs" << setw(8) << "Split" << setw(12) << "Train Loss" << setw(12) << "Test Loss" << setw(12) << "Train Acc" << setw(12) << "Test Acc" << setw(15) << "Description" << endl;
-    cout << string(120, '-') << endl;
+    cout << left << setw(25) << "Architecture" << setw(10) << "LR" << setw(8) << "Epochs" << setw(8) << "Used" << setw(8) << "Split" << setw(12) << "Train Loss" << setw(12) << "Test Loss" << setw(12) << "Train Acc" << setw(12) << "Test Acc" << setw(10) << "Int8 Acc" << setw(15) << "Description" << endl;
+    cout << string(138, '-') << endl;
     
     for (auto result : results) {
-        string archStr = "";
-        for (size_t i = 0; i < result.config.architecture.size(); ++i) {
-            archStr += to_string(result.config.architecture[i]);
-            if (i < result.config.architecture.size() - 1) archStr += "-";
-        }
+        string archStr = architectureString(result.config.architecture);
         
-        cout << left << setw(25) << archStr << setw(10) << fixed << setprecision(3) << result.config.learningRate << setw(8) << result.config.epochs << setw(8) << fixed << setprecision(2) << result.splitRatio << setw(12) << fixed << setprecision(4) << result.trainLoss << setw(12) << fixed << setprecision(4) << result.testLoss << setw(12) << fixed << setprecision(3) << result.trainAccuracy << setw(12) << fixed << setprecision(3) << result.testAccuracy << setw(15) << result.config.description << endl;
+        cout << left << setw(25) << archStr << setw(10) << fixed << setprecision(3) << result.config.learningRate << setw(8) << result.config.epochs << setw(8) << result.epochsUsed << setw(8) << fixed << setprecision(2) << result.splitRatio << setw(12) << fixed << setprecision(4) << result.trainLoss << setw(12) << fixed << setprecision(4) << result.testLoss << setw(12) << fixed << setprecision(3) << result.trainAccuracy << setw(12) << fixed << setprecision(3) << result.testAccuracy << setw(10) << fixed << setprecision(3) << result.int8TestAccuracy << setw(15) << result.config.description << endl;
     }
-    cout << string(120, '-') << endl;
+    cout << string(138, '-') << endl;
 }
 
 template<typename T>
@@ -194,19 +238,261 @@ void printBestConfigurations(vector<typename MLPExperimentTypes<T>::ExperimentRe
     cout << "Best Test Loss: " << fixed << setprecision(4) << bestLoss.testLoss  << " (" << bestLoss.config.description << ")" << endl;
 }
 
-int main() {
-    using ExpTypes = MLPExperimentTypes<double>;
-    using Dataset = ExpTypes::Dataset;
-    using HyperparameterConfig = ExpTypes::HyperparameterConfig;
-    using ExperimentResult = ExpTypes::ExperimentResult;
-    
+struct SweepOptions {
+    bool enabled = false;
+    int seeds = 1;
+    size_t threads = 0;
+    string csvPath = "sweep_results.csv";
+    string jsonPath = "";
+    string checkpointDir = "";
+    // --float runs the suite (interactive or sweep) in float32.
+    bool floatPrecision = false;
+    // --early-stop N stops a run once its training loss has gone N epochs
+    // without improving; 0 trains every config for its full epoch count.
+    int earlyStopPatience = 0;
+    // --seed is the seed of every config (the sweep's first seed) and
+    // --init its parameter initialization.
+    int seed = 42;
+    InitScheme init = InitScheme::Uniform;
+};
+
+bool parseInitScheme(const char* name, InitScheme& scheme) {
+    for (InitScheme candidate : {InitScheme::Uniform, InitScheme::XavierUniform, InitScheme::XavierNormal, InitScheme::HeUniform, InitScheme::HeNormal}) {
+        if (strcmp(name, initSchemeName(candidate)) == 0) {
+            scheme = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Throws invalid_argument on an unknown flag, a missing value or a value
+// that is not a valid count.
+void parseSweepOptions(int argc, char* argv[], SweepOptions& options) {
+    const uint64_t intMax = uint64_t(numeric_limits<int>::max());
+    for (int i = 1; i < argc; ++i) {
+        const char* option = argv[i];
+        if (strcmp(option, "--sweep") == 0) {
+            options.enabled = true;
+            continue;
+        }
+        if (strcmp(option, "--float") == 0) {
+            options.floatPrecision = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            throw invalid_argument(string("Missing value for ") + option);
+        }
+        const char* value = argv[++i];
+        if (strcmp(option, "--early-stop") == 0) {
+            options.earlyStopPatience = int(parseCount(option, value, intMax));
+        } else if (strcmp(option, "--seeds") == 0) {
+            options.seeds = int(parseCount(option, value, intMax));
+            if (options.seeds == 0) {
+                throw invalid_argument("--seeds must be at least 1");
+            }
+        } else if (strcmp(option, "--seed") == 0) {
+            options.seed = int(parseCount(option, value, intMax));
+        } else if (strcmp(option, "--init") == 0) {
+            if (!parseInitScheme(value, options.init)) {
+                throw invalid_argument(string("Unknown init scheme ") + value);
+            }
+        } else if (strcmp(option, "--threads") == 0) {
+            options.threads = size_t(parseCount(option, value));
+        } else if (strcmp(option, "--csv") == 0) {
+            options.csvPath = value;
+        } else if (strcmp(option, "--json") == 0) {
+            options.jsonPath = value;
+        } else if (strcmp(option, "--checkpoint-dir") == 0) {
+            options.checkpointDir = value;
+        } else {
+            throw invalid_argument(string("Unknown option ") + option);
+        }
+    }
+}
+
+string jsonEscape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Appends one CSV row and, when enabled, one JSON line per finished run and
+// flushes both, so a sweep that dies part way still leaves every result that
+// completed. Safe to call from several worker threads.
+template<typename T>
+class SweepWriter {
+private:
+    mutex lock;
+    ofstream csv;
+    ofstream json;
+
+public:
+    SweepWriter(const string& csvPath, const string& jsonPath) {
+        if (!csvPath.empty()) {
+            csv.open(csvPath);
+            if (!csv.is_open()) {
+                cerr << "Error: Cannot open file " << csvPath << endl;
+            }
+            csv << "dataset,description,architecture,learning_rate,epochs,epochs_used,batch_size,split,seed,init,train_loss,test_loss,train_accuracy,test_accuracy,int8_test_accuracy,seconds,samples_per_sec" << endl;
+        }
+        if (!jsonPath.empty()) {
+            json.open(jsonPath);
+            if (!json.is_open()) {
+                cerr << "Error: Cannot open file " << jsonPath << endl;
+            }
+        }
+    }
+
+    void write(const string& datasetName, const typename MLPExperimentTypes<T>::ExperimentResult& result) {
+        unique_lock<mutex> guard(lock);
+        const string arch = architectureString(result.config.architecture);
+        if (csv.is_open()) {
+            csv << datasetName << "," << result.config.description << "," << arch << "," << result.config.learningRate << "," << result.config.epochs << "," << result.epochsUsed << "," << result.config.batchSize << "," << result.splitRatio << "," << result.seed << "," << initSchemeName(result.config.init) << "," << result.trainLoss << "," << result.testLoss << "," << result.trainAccuracy << "," << result.testAccuracy << "," << result.int8TestAccuracy << "," << result.seconds << "," << result.samplesPerSecond << endl;
+        }
+        if (json.is_open()) {
+            json << "{\"dataset\":\"" << jsonEscape(datasetName) << "\",\"description\":\"" << jsonEscape(result.config.description) << "\",\"architecture\":\"" << arch << "\",\"learning_rate\":" << result.config.learningRate << ",\"epochs\":" << result.config.epochs << ",\"epochs_used\":" << result.epochsUsed << ",\"batch_size\":" << result.config.batchSize << ",\"split\":" << result.splitRatio << ",\"seed\":" << result.seed << ",\"init\":\"" << initSchemeName(result.config.init) << "\",\"train_loss\":" << result.trainLoss << ",\"test_loss\":" << result.testLoss << ",\"train_accuracy\":" << result.trainAccuracy << ",\"test_accuracy\":" << result.testAccuracy << ",\"int8_test_accuracy\":" << result.int8TestAccuracy << ",\"seconds\":" << result.seconds << ",\"samples_per_sec\":" << result.samplesPerSecond;
+            // One entry per output bit: accuracy, and [tp, fp, tn, fn].
+            json << ",\"test_output_accuracy\":[";
+            for (size_t i = 0; i < result.testOutputAccuracy.size(); ++i) {
+                json << (i > 0 ? "," : "") << result.testOutputAccuracy[i];
+            }
+            json << "],\"test_confusion\":[";
+            for (size_t i = 0; i < result.testConfusion.size(); ++i) {
+                const OutputConfusion& counts = result.testConfusion[i];
+                json << (i > 0 ? "," : "") << "[" << counts.truePositive << "," << counts.falsePositive << "," << counts.trueNegative << "," << counts.falseNegative << "]";
+            }
+            json << "]}" << endl;
+        }
+    }
+};
+
+// Runs every config x split x seed combination for each dataset on a thread
+// pool. Each run trains single-threaded; the most expensive runs are started
+// first so the sweep finishes close to the time of its slowest run.
+template<typename T>
+void runSweep(const vector<pair<const typename MLPExperimentTypes<T>::Dataset*, const vector<typename MLPExperimentTypes<T>::HyperparameterConfig>*>>& grids, const vector<T>& splitRatios, const SweepOptions& options) {
+    using ExperimentResult = typename MLPExperimentTypes<T>::ExperimentResult;
+
+    struct SweepRun {
+        size_t grid;
+        size_t config;
+        T split;
+        int seed;
+        double cost;
+    };
+
+    vector<SweepRun> runs;
+    for (size_t g = 0; g < grids.size(); ++g) {
+        const auto& configs = *grids[g].second;
+        for (size_t c = 0; c < configs.size(); ++c) {
+            double parameters = 0.0;
+            for (size_t i = 0; i + 1 < configs[c].architecture.size(); ++i) {
+                parameters += double(configs[c].architecture[i] + 1) * double(configs[c].architecture[i + 1]);
+            }
+            for (T split : splitRatios) {
+                for (int s = 0; s < options.seeds; ++s) {
+                    const double cost = parameters * double(configs[c].epochs) * double(grids[g].first->samples.size()) * double(split);
+                    runs.push_back({g, c, split, configs[c].seed + s, cost});
+                }
+            }
+        }
+    }
+
+    vector<size_t> order(runs.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return runs[a].cost > runs[b].cost; });
+
+    if (!options.checkpointDir.empty()) {
+        filesystem::create_directories(options.checkpointDir);
+    }
+
+    ThreadPool pool(options.threads);
+    SweepWriter<T> writer(options.csvPath, options.jsonPath);
+    vector<ExperimentResult> results(runs.size());
+    mutex progressLock;
+    size_t completed = 0;
+
+    cout << "\nRunning " << runs.size() << " experiments on " << pool.size() << " threads..." << endl;
+    auto start = chrono::steady_clock::now();
+
+    pool.parallelFor(order.size(), [&](size_t i) {
+        const SweepRun& run = runs[order[i]];
+        const auto& dataset = *grids[run.grid].first;
+        auto config = (*grids[run.grid].second)[run.config];
+        config.threads = 1;
+        config.seed = run.seed;
+        if (!options.checkpointDir.empty()) {
+            // The precision keeps a --float sweep from picking up a double
+            // run's checkpoints in the same directory.
+            string name = dataset.name + "_" + to_string(run.config) + "_" + to_string(int(run.split * 100)) + "_" + to_string(run.seed) + (is_same<T, float>::value ? "_float32" : "_float64") + ".ckpt";
+            replace(name.begin(), name.end(), ' ', '_');
+            config.checkpointPath = options.checkpointDir + "/" + name;
+            config.checkpointInterval = 100;
+        }
+
+        auto [train, test] = splitDataset<T>(dataset, run.split, config.seed);
+        ExperimentResult result = runExperiment<T>(train, test, config, run.split);
+        results[order[i]] = result;
+        writer.write(dataset.name, result);
+
+        unique_lock<mutex> guard(progressLock);
+        ++completed;
+        cout << "[" << completed << "/" << runs.size() << "] " << dataset.name << " " << config.description << " split=" << fixed << setprecision(2) << run.split << " seed=" << run.seed << " " << setprecision(3) << result.seconds << "s " << setprecision(0) << result.samplesPerSecond << " samples/s" << endl;
+    });
+
+    const double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double runSeconds = 0.0;
+    double slowestSeconds = 0.0;
+    for (const ExperimentResult& result : results) {
+        runSeconds += result.seconds;
+        slowestSeconds = max(slowestSeconds, result.seconds);
+    }
+
+    for (size_t g = 0; g < grids.size(); ++g) {
+        vector<ExperimentResult> gridResults;
+        for (size_t r = 0; r < runs.size(); ++r) {
+            if (runs[r].grid == g) {
+                gridResults.push_back(results[r]);
+            }
+        }
+        string datasetName = grids[g].first->name;
+        transform(datasetName.begin(), datasetName.end(), datasetName.begin(), ::toupper);
+        printResults<T>(gridResults, datasetName);
+        printBestConfigurations<T>(gridResults, datasetName);
+    }
+
+    cout << "\n" << string(80, '=') << endl;
+    cout << "SWEEP SUMMARY" << endl;
+    cout << string(80, '=') << endl;
+    cout << "Experiments: " << runs.size() << " on " << pool.size() << " threads" << endl;
+    cout << "Wall clock: " << fixed << setprecision(3) << wallSeconds << "s (slowest run " << slowestSeconds << "s, sum of runs " << runSeconds << "s)" << endl;
+    if (!options.csvPath.empty()) cout << "CSV results: " << options.csvPath << endl;
+    if (!options.jsonPath.empty()) cout << "JSON results: " << options.jsonPath << endl;
+}
+
+// The whole experiment suite at precision T: double by default, float with
+// --float.
+template<typename T>
+int runSuite(const SweepOptions& sweepOptions) {
+    using ExpTypes = MLPExperimentTypes<T>;
+    using Dataset = typename ExpTypes::Dataset;
+    using HyperparameterConfig = typename ExpTypes::HyperparameterConfig;
+    using ExperimentResult = typename ExpTypes::ExperimentResult;
+
     cout << string(80, '=') << endl;
     cout << "MULTILAYER PERCEPTRON COMPREHENSIVE EXPERIMENT SUITE" << endl;
     cout << string(80, '=') << endl;
+    if (is_same<T, float>::value) {
+        cout << "Precision: float32 (loss and gradient sums in double)" << endl;
+    }
     
     cout << "\n[1] Loading Datasets..." << endl;
-    Dataset xorDataset = loadDatasetFromCSV<double>("datasets/xor_dataset.csv", "XOR");
-    Dataset adderDataset = loadDatasetFromCSV<double>("datasets/binary_adder_dataset.csv", "Binary Adder");
+    Dataset xorDataset = loadDatasetFromCSV<T>("datasets/xor_dataset.csv", "XOR", {{"x1", "x2"}, {"y"}});
+    Dataset adderDataset = loadDatasetFromCSV<T>("datasets/binary_adder_dataset.csv", "Binary Adder", {{"a0", "b0", "c0", "a1", "b1"}, {"s0", "s1", "c2"}});
     
     cout << "✓ XOR Dataset: " << xorDataset.samples.size() << " samples, " << xorDataset.inputDim << " inputs, " << xorDataset.outputDim << " outputs" << endl;
     cout << "✓ Binary Adder Dataset: " << adderDataset.samples.size() << " samples, " << adderDataset.inputDim << " inputs, " << adderDataset.outputDim << " outputs" << endl;
@@ -246,7 +532,20 @@ int main() {
     cout << "✓ Defined " << xorConfigs.size() << " configurations for XOR" << endl;
     cout << "✓ Defined " << adderConfigs.size() << " configurations for Binary Adder" << endl;
     
-    vector<double> splitRatios = {0.5, 0.7, 0.8};
+    for (auto* configs : {&xorConfigs, &adderConfigs}) {
+        for (HyperparameterConfig& config : *configs) {
+            config.seed = sweepOptions.seed;
+            config.init = sweepOptions.init;
+            config.earlyStopping.patience = sweepOptions.earlyStopPatience;
+        }
+    }
+
+    vector<T> splitRatios = {0.5, 0.7, 0.8};
+
+    if (sweepOptions.enabled) {
+        runSweep<T>({{&xorDataset, &xorConfigs}, {&adderDataset, &adderConfigs}}, splitRatios, sweepOptions);
+        return 0;
+    }
     
     cout << "\n[3] Choose Configuration for XOR Experiments..." << endl;
     
@@ -292,8 +591,8 @@ int main() {
     cout << "Config: " << xorConfigs[xorChoice].description << endl;
     cout << "Split: " << splitRatios[splitChoice] << endl;
     
-    auto [xorTrain, xorTest] = splitDataset<double>(xorDataset, splitRatios[splitChoice]);
-    ExperimentResult result = runExperiment<double>(xorTrain, xorTest, xorConfigs[xorChoice], splitRatios[splitChoice]);
+    auto [xorTrain, xorTest] = splitDataset<T>(xorDataset, splitRatios[splitChoice], xorConfigs[xorChoice].seed);
+    ExperimentResult result = runExperiment<T>(xorTrain, xorTest, xorConfigs[xorChoice], splitRatios[splitChoice]);
     xorResults.push_back(result);
     
     cout << "\n[4] Choose Configuration for Binary Adder Experiments..." << endl;
@@ -339,17 +638,17 @@ int main() {
     cout << "Config: " << adderConfigs[adderChoice].description << endl;
     cout << "Split: " << splitRatios[adderSplitChoice] << endl;
     
-    auto [adderTrain, adderTest] = splitDataset<double>(adderDataset, splitRatios[adderSplitChoice]);
-    ExperimentResult adderResult = runExperiment<double>(adderTrain, adderTest, adderConfigs[adderChoice], splitRatios[adderSplitChoice]);
+    auto [adderTrain, adderTest] = splitDataset<T>(adderDataset, splitRatios[adderSplitChoice], adderConfigs[adderChoice].seed);
+    ExperimentResult adderResult = runExperiment<T>(adderTrain, adderTest, adderConfigs[adderChoice], splitRatios[adderSplitChoice]);
     adderResults.push_back(adderResult);
     
     cout << "\n[5] Results Analysis..." << endl;
     
-    printResults<double>(xorResults, "XOR");
-    printBestConfigurations<double>(xorResults, "XOR");
+    printResults<T>(xorResults, "XOR");
+    printBestConfigurations<T>(xorResults, "XOR");
     
-    printResults<double>(adderResults, "BINARY ADDER");
-    printBestConfigurations<double>(adderResults, "BINARY ADDER");
+    printResults<T>(adderResults, "BINARY ADDER");
+    printBestConfigurations<T>(adderResults, "BINARY ADDER");
     
     cout << "\n" << string(80, '=') << endl;
     cout << "EXPERIMENT SUMMARY" << endl;
@@ -369,4 +668,15 @@ int main() {
     cout << string(80, '=') << endl;
     
     return 0;
-}
\ No newline at end of file
+}
+int main(int argc, char* argv[]) {
+    SweepOptions sweepOptions;
+    try {
+        parseSweepOptions(argc, argv, sweepOptions);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        cerr << "Usage: " << argv[0] << " [--float] [--early-stop N] [--seed N] [--init uniform|xavier-uniform|xavier-normal|he-uniform|he-normal] [--sweep [--seeds N] [--threads N] [--csv FILE] [--json FILE] [--checkpoint-dir DIR]]" << endl;
+        return 1;
+    }
+    return sweepOptions.floatPrecision ? runSuite<float>(sweepOptions) : runSuite<double>(sweepOptions);
+}
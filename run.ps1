@@ -3,7 +3,7 @@ Write-Host "=== Compiling Multilayer Perceptron Implementation ===" -ForegroundC
 Write-Host "Compiling main.cpp with headers: Complex.h, Matrix.h, MLP.h" -ForegroundColor Cyan
 
 # Compile the program
-$compileResult = Start-Process -FilePath "g++" -ArgumentList @("-std=c++17", "-Wall", "-Wextra", "-O2", "-I.", "main.cpp", "-o", "mlp_train") -Wait -PassThru
+$compileResult = Start-Process -FilePath "g++" -ArgumentList @("-std=c++17", "-Wall", "-Wextra", "-O2", "-pthread", "-I.", "main.cpp", "-o", "mlp_train") -Wait -PassThru
 
 # Check if compilation was successful
 if ($compileResult.ExitCode -eq 0) {
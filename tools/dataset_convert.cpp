@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "headers/CsvLoader.h"
+#include "headers/BinaryDataset.h"
+
+using namespace std;
+
+// Converts a headered CSV into the binary dataset format.
+//   dataset_convert input.csv output.bin --outputs 3
+//   dataset_convert input.csv output.bin --inputs a0,b0 --outputs s0,s1 --dtype float32
+// A numeric --outputs takes that many trailing columns as labels; without
+// --inputs every other column is an input.
+
+vector<string> splitList(const string& list) {
+    vector<string> names;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == string::npos) comma = list.size();
+        names.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return names;
+}
+
+bool isCount(const string& text) {
+    return !text.empty() && text.find_first_not_of("0123456789") == string::npos;
+}
+
+template<typename T>
+void convert(const string& input, const string& output, const CsvColumns& columns) {
+    auto start = chrono::steady_clock::now();
+    CsvTable<T> table = loadCsv<T>(input, columns);
+    writeBinaryDataset<T>(output, table.features.data(), table.labels.data(), table.rows, table.inputDim, table.outputDim);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Wrote " << table.rows << " rows (" << table.inputDim << " inputs, " << table.outputDim << " outputs) to " << output << " in " << seconds << "s" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " input.csv output.bin --outputs N|names [--inputs names] [--dtype float32|float64]" << endl;
+        return 1;
+    }
+
+    const string input = argv[1];
+    const string output = argv[2];
+    string inputList, outputList, dtype = "float64";
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--inputs") == 0) inputList = argv[i + 1];
+        else if (strcmp(argv[i], "--outputs") == 0) outputList = argv[i + 1];
+        else if (strcmp(argv[i], "--dtype") == 0) dtype = argv[i + 1];
+        else {
+            cerr << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    try {
+        MappedFile file(input);
+        vector<string> header = csv::splitHeader(file.data(), csv::lineEnd(file.data(), file.data() + file.size()));
+
+        CsvColumns columns;
+        if (isCount(outputList)) {
+            size_t count = min<size_t>(stoul(outputList), header.size());
+            columns.outputs.assign(header.end() - count, header.end());
+        } else {
+            columns.outputs = splitList(outputList);
+        }
+        if (!inputList.empty()) {
+            columns.inputs = splitList(inputList);
+        } else {
+            for (const string& name : header) {
+                if (find(columns.outputs.begin(), columns.outputs.end(), name) == columns.outputs.end()) {
+                    columns.inputs.push_back(name);
+                }
+            }
+        }
+
+        if (dtype == "float32") {
+            convert<float>(input, output, columns);
+        } else if (dtype == "float64") {
+            convert<double>(input, output, columns);
+        } else {
+            cerr << "Unknown dtype " << dtype << endl;
+            return 1;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
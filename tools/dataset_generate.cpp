@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "headers/SyntheticData.h"
+#include "headers/CommandLine.h"
+
+using namespace std;
+
+// Writes an n-bit adder, XOR or parity dataset as CSV or binary.
+//   dataset_generate adder8.bin --task adder --bits 8 --rows 1000000 --seed 1 --dtype float32
+//   dataset_generate parity4.csv --task parity --bits 4
+// Without --rows every input pattern is written once. Files ending in .csv
+// are CSV; anything else uses the binary dataset format.
+
+bool parseTask(const string& name, SyntheticTask& task) {
+    for (SyntheticTask candidate : {SyntheticTask::Adder, SyntheticTask::Xor, SyntheticTask::Parity}) {
+        if (name == syntheticTaskName(candidate)) {
+            task = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool endsWith(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const string usage = string("Usage: ") + argv[0] + " output.csv|output.bin [--task adder|xor|parity] [--bits N] [--rows N] [--seed N] [--no-carry] [--dtype float32|float64] [--threads N]";
+    if (argc < 2) {
+        cerr << usage << endl;
+        return 1;
+    }
+
+    const string output = argv[1];
+    SyntheticConfig config;
+    string dtype = "float64";
+    size_t threads = 0;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const char* option = argv[i];
+            if (strcmp(option, "--no-carry") == 0) {
+                config.carryIn = false;
+                continue;
+            }
+            if (i + 1 == argc) {
+                throw invalid_argument(string("Missing value for ") + option);
+            }
+            const char* value = argv[++i];
+            if (strcmp(option, "--task") == 0) {
+                if (!parseTask(value, config.task)) {
+                    throw invalid_argument(string("Unknown task ") + value);
+                }
+            } else if (strcmp(option, "--bits") == 0) {
+                config.bits = size_t(parseCount(option, value));
+            } else if (strcmp(option, "--rows") == 0) {
+                config.rows = size_t(parseCount(option, value));
+            } else if (strcmp(option, "--seed") == 0) {
+                config.seed = parseCount(option, value);
+            } else if (strcmp(option, "--dtype") == 0) {
+                dtype = value;
+            } else if (strcmp(option, "--threads") == 0) {
+                threads = size_t(parseCount(option, value));
+            } else {
+                throw invalid_argument(string("Unknown option ") + option);
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl << usage << endl;
+        return 1;
+    }
+
+    try {
+        const auto start = chrono::steady_clock::now();
+        if (endsWith(output, ".csv")) {
+            writeSyntheticCsv(config, output, threads);
+        } else if (dtype == "float32") {
+            writeSyntheticBinary<float>(config, output, threads);
+        } else if (dtype == "float64") {
+            writeSyntheticBinary<double>(config, output, threads);
+        } else {
+            cerr << "Unknown dtype " << dtype << endl;
+            return 1;
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const size_t rows = syntheticRows(config);
+        cout << "Wrote " << rows << " rows of " << config.bits << "-bit " << syntheticTaskName(config.task) << " (" << syntheticInputs(config) << " inputs, "
+             << syntheticOutputs(config) << " outputs) to " << output << " in " << seconds << "s, " << double(rows) / seconds / 1e6 << "M rows/s" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <list>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "headers/Checkpoint.h"
+#include "headers/CommandLine.h"
+#include "headers/InferenceServer.h"
+
+using namespace std;
+
+// Serves a checkpoint over stdin/stdout, or over a Unix domain socket with
+// --socket. Each request line holds one sample's features; each response
+// line holds its outputs, in request order per client. "stats" returns the
+// server metrics as JSON.
+//   mlp_serve model.ckpt [--socket PATH] [--max-batch N] [--max-wait-us N] [--max-queue N]
+
+atomic<bool> stopRequested{false};
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+// Splits buffered input into lines and submits each complete one.
+template<typename Batcher>
+void serveStream(int fd, const shared_ptr<ResponseSink>& sink, Batcher& batcher) {
+    vector<char> buffer(1 << 16);
+    size_t used = 0;
+    while (true) {
+        if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t n = read(fd, buffer.data() + used, buffer.size() - used);
+        if (n <= 0) {
+            break;
+        }
+        used += size_t(n);
+
+        size_t start = 0;
+        for (size_t i = 0; i < used; ++i) {
+            if (buffer[i] == '\n') {
+                batcher.submit(sink, buffer.data() + start, i - start);
+                start = i + 1;
+            }
+        }
+        memmove(buffer.data(), buffer.data() + start, used - start);
+        used -= start;
+    }
+    if (used > 0) {
+        batcher.submit(sink, buffer.data(), used);
+    }
+}
+
+struct Connection {
+    thread reader;
+    weak_ptr<ResponseSink> sink;
+    atomic<bool> finished{false};
+};
+
+template<typename Batcher>
+int serveSocket(const string& path, Batcher& batcher) {
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: cannot create socket " << path << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        cerr << "Error: cannot listen on " << path << ": " << strerror(errno) << endl;
+        close(listener);
+        return 1;
+    }
+    cerr << "Listening on " << path << endl;
+
+    list<Connection> connections;
+    while (!stopRequested) {
+        int client = accept(listener, nullptr, nullptr);
+
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->finished) {
+                it->reader.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (client < 0) {
+            continue;
+        }
+
+        auto sink = make_shared<ResponseSink>(client, true);
+        connections.emplace_back();
+        Connection& connection = connections.back();
+        connection.sink = sink;
+        connection.reader = thread([sink, &batcher, &connection] {
+            serveStream(sink->descriptor(), sink, batcher);
+            connection.finished = true;
+        });
+    }
+
+    close(listener);
+    unlink(path.c_str());
+    for (Connection& connection : connections) {
+        if (shared_ptr<ResponseSink> sink = connection.sink.lock()) {
+            shutdown(sink->descriptor(), SHUT_RD);
+        }
+        connection.reader.join();
+    }
+    return 0;
+}
+
+template<typename T>
+int serve(const string& modelPath, const string& socketPath, const ServerOptions& options) {
+    MappedModel<T> model(modelPath);
+    cerr << "Serving " << modelPath << " (" << model.inputSize() << " inputs, " << model.outputSize() << " outputs), max batch " << options.maxBatch << ", max wait " << options.maxWait.count() << "us" << endl;
+
+    MicroBatcher<T, MappedModel<T>> batcher(model, options);
+    int status = 0;
+    if (socketPath.empty()) {
+        serveStream(STDIN_FILENO, make_shared<ResponseSink>(STDOUT_FILENO, false), batcher);
+    } else {
+        status = serveSocket(socketPath, batcher);
+    }
+    batcher.shutdown();
+    cerr << batcher.metricsJson() << endl;
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    const string usage = string("Usage: ") + argv[0] + " model.ckpt [--socket PATH] [--max-batch N] [--max-wait-us N] [--max-queue N]";
+    if (argc < 2) {
+        cerr << usage << endl;
+        return 1;
+    }
+
+    const string modelPath = argv[1];
+    string socketPath;
+    ServerOptions options;
+    try {
+        for (int i = 2; i < argc; i += 2) {
+            if (i + 1 == argc) {
+                throw invalid_argument(string("Missing value for ") + argv[i]);
+            }
+            if (strcmp(argv[i], "--socket") == 0) socketPath = argv[i + 1];
+            else if (strcmp(argv[i], "--max-batch") == 0) options.maxBatch = max<size_t>(1, parseCount(argv[i], argv[i + 1]));
+            else if (strcmp(argv[i], "--max-wait-us") == 0) options.maxWait = chrono::microseconds(parseCount(argv[i], argv[i + 1]));
+            else if (strcmp(argv[i], "--max-queue") == 0) options.maxQueue = max<size_t>(1, parseCount(argv[i], argv[i + 1]));
+            else throw invalid_argument(string("Unknown option ") + argv[i]);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl << usage << endl;
+        return 1;
+    }
+
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        MappedFile file(modelPath);
+        CheckpointHeader header{};
+        if (file.size() >= sizeof(header)) {
+            memcpy(&header, file.data(), sizeof(header));
+        }
+        if (header.dtype == uint32_t(DatasetType::Float32)) {
+            return serve<float>(modelPath, socketPath, options);
+        }
+        return serve<double>(modelPath, socketPath, options);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}